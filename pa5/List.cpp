@@ -10,69 +10,632 @@
 #include<iostream>
 #include<string>
 #include<stdexcept>
+#include<algorithm>
+#include<unordered_set>
+#include<new>
 #include "List.h"
 
+// Nodes are carved from slabs owned by each List and recycled through a free
+// list threaded through Node::next, so inserting and erasing do not touch the
+// heap once a List has grown, and clear() and the destructor free whole
+// slabs. Slabs start at LIST_FIRST_SLAB_NODES Nodes and double up to
+// LIST_MAX_SLAB_NODES. Define LIST_NO_NODE_POOL to allocate every Node with
+// new and delete instead.
+#ifndef LIST_FIRST_SLAB_NODES
+#define LIST_FIRST_SLAB_NODES 4
+#endif
+#ifndef LIST_MAX_SLAB_NODES
+#define LIST_MAX_SLAB_NODES 256
+#endif
+
+// Slots the chunk index searches on either side of a new chunk for a free
+// one before it is rebuilt.
+#ifndef LIST_SLOT_WINDOW
+#define LIST_SLOT_WINDOW 16
+#endif
+
 
 // Private constructor --------------------------------------------------------
 
-List::Node::Node(ListElement x) {
-    data = x;
+List::Link::Link() {
     next = nullptr;
     prev = nullptr;
+    count = 0;
+    slot = -1;
+}
+
+// leaves data uninitialized, as Link() sets up the rest
+List::Node::Node() {
+}
+
+// Slab header, followed in memory by room for capacity Nodes, of which the
+// first used have been handed out.
+struct List::Slab{
+    Slab* next;
+    int capacity;
+    int used;
+
+    Node* nodes() { return reinterpret_cast<Node*>(this + 1); }
+};
+
+
+// Node allocation ------------------------------------------------------------
+
+// newNode()
+// Returns a new empty Node, taken from this List's pool.
+List::Node* List::newNode() {
+#ifdef LIST_NO_NODE_POOL
+    return new Node();
+#else
+    Node* N = free_nodes;
+
+    if( N!=nullptr ) {
+        free_nodes = node(N->next);
+    }
+    else {
+        // carve the next Node from the newest slab, starting one if it is full
+        if( slabs==nullptr || slabs->used==slabs->capacity ) {
+            reserveNodes(1);
+        }
+        N = slabs->nodes() + slabs->used++;
+    }
+
+    return new (N) Node();
+#endif
+}
+
+// freeNode()
+// Returns N to this List's pool.
+void List::freeNode(Node* N) {
+#ifdef LIST_NO_NODE_POOL
+    delete N;
+#else
+    if( free_nodes==nullptr ) {
+        free_tail = N;
+    }
+    N->next = free_nodes;
+    free_nodes = N;
+#endif
+}
+
+// reserveNodes()
+// Makes room in the pool for n more Nodes without further allocation.
+void List::reserveNodes(int n) {
+#ifndef LIST_NO_NODE_POOL
+    if( slabs!=nullptr ) {
+        n -= slabs->capacity - slabs->used;
+    }
+    for( Node* N = free_nodes; N!=nullptr && n>0; N = node(N->next) ) {
+        n--;
+    }
+    if( n<=0 ) {
+        return;
+    }
+
+    static_assert(sizeof(Slab)%alignof(Node)==0, "List: Slab header misaligns Nodes");
+
+    int capacity = (n>slab_nodes) ? n : slab_nodes;
+    Slab* S = static_cast<Slab*>(::operator new(sizeof(Slab) + capacity*sizeof(Node)));
+
+    if( slabs==nullptr ) {
+        slabs_tail = S;
+    }
+    S->next = slabs;
+    S->capacity = capacity;
+    S->used = 0;
+    slabs = S;
+
+    if( slab_nodes<LIST_MAX_SLAB_NODES ) {
+        slab_nodes *= 2;
+    }
+#else
+    (void)n;
+#endif
+}
+
+// releaseSlabs()
+// Frees every slab, or every slab but the newest if keep is true, leaving
+// no Nodes in use.
+void List::releaseSlabs(bool keep) {
+    Slab* S = slabs;
+
+    if( keep && S!=nullptr ) {
+        S->used = 0;
+        S = S->next;
+        slabs->next = nullptr;
+        slabs_tail = slabs;
+    }
+    else {
+        slabs = nullptr;
+    }
+
+    while( S!=nullptr ) {
+        Slab* next = S->next;
+        ::operator delete(S);
+        S = next;
+    }
+
+    free_nodes = nullptr;
+}
+
+
+// Chunk maintenance ----------------------------------------------------------
+
+// node()
+// Returns the Node whose ring fields are N.
+// pre: N is not the dummy
+List::Node* List::node(Link* N) {
+    return static_cast<Node*>(N);
+}
+
+// linkNode()
+// Links N into the ring after P.
+void List::linkNode(Node* N, Link* P) {
+    N->prev = P;
+    N->next = P->next;
+    P->next->prev = N;
+    P->next = N;
+
+    // N takes a free slot between the slots of its neighbors
+    ChunkIndex& X = chunk_index;
+    if( X.valid ) {
+        int before = (P==&dummy) ? -1 : P->slot;
+        int after = (N->next==&dummy) ? int(X.chunks.size()) : N->next->slot;
+        int s = freeSlot(before, after);
+
+        if( s>=0 ) {
+            N->slot = s;
+            X.chunks[s] = N;
+        }
+        else {
+            X.valid = false;
+        }
+    }
+}
+
+// dropNode()
+// Unlinks N from the ring and returns it to the pool. N holds no elements,
+// or they were moved out and recorded with addCount().
+void List::dropNode(Node* N) {
+    ChunkIndex& X = chunk_index;
+
+    // N's slot, which now counts nothing, becomes free
+    if( X.valid ) {
+        if( N==X.pending_node ) {
+            foldPending();
+            X.pending_node = nullptr;
+        }
+        X.chunks[N->slot] = nullptr;
+    }
+
+    N->prev->next = N->next;
+    N->next->prev = N->prev;
+    freeNode(N);
+}
+
+// makeRoom()
+// Moves the cursor to an equivalent place in a chunk with a free slot,
+// starting or splitting a chunk if there is none.
+void List::makeRoom() {
+    Link* N = cursorNode;
+
+    if( N!=&dummy && N->count<CHUNK ) {
+        return;
+    }
+
+    // the cursor may equally stand at the end of the previous chunk, or at
+    // the start of the next one
+    if( cursorIndex==0 && N->prev!=&dummy && N->prev->count<CHUNK ) {
+        cursorNode = N->prev;
+        cursorIndex = cursorNode->count;
+        return;
+    }
+    if( N!=&dummy && cursorIndex==N->count && N->next!=&dummy && N->next->count<CHUNK ) {
+        cursorNode = N->next;
+        cursorIndex = 0;
+        return;
+    }
+
+    // at the back, start a new chunk
+    if( N==&dummy ) {
+        Node* M = newNode();
+        linkNode(M, dummy.prev);
+        cursorNode = M;
+        cursorIndex = 0;
+        return;
+    }
+
+    // otherwise split the full chunk in half
+    Node* F = node(N);
+    Node* M = newNode();
+    int half = CHUNK/2;
+
+    linkNode(M, F);
+    std::copy(F->data + half, F->data + CHUNK, M->data);
+    M->count = CHUNK - half;
+    F->count = half;
+    addCount(F, -M->count);
+    addCount(M, M->count);
+
+    if( cursorIndex>half ) {
+        cursorNode = M;
+        cursorIndex -= half;
+    }
+}
+
+// shrink()
+// Frees the cursor's chunk N if it is empty, or merges it with a neighbor
+// if it is less than half full and both fit in one chunk.
+void List::shrink(Node* N) {
+    if( N->count==0 ) {
+        cursorNode = N->next;
+        cursorIndex = 0;
+        dropNode(N);
+        return;
+    }
+    if( N->count>=CHUNK/2 ) {
+        return;
+    }
+
+    Link* next = N->next;
+    if( next!=&dummy && N->count + next->count<=CHUNK ) {
+        Node* M = node(next);
+        std::copy_n(M->data, M->count, N->data + N->count);
+        N->count += M->count;
+        addCount(M, -M->count);
+        addCount(N, M->count);
+        dropNode(M);
+        return;
+    }
+
+    Link* prev = N->prev;
+    if( prev!=&dummy && prev->count + N->count<=CHUNK ) {
+        Node* P = node(prev);
+        std::copy_n(N->data, N->count, P->data + P->count);
+        cursorNode = P;
+        cursorIndex += P->count;
+        P->count += N->count;
+        addCount(N, -N->count);
+        addCount(P, N->count);
+        dropNode(N);
+    }
+}
+
+// locate()
+// Returns the chunk holding position i and sets k to the offset of i in
+// it, 0<=k<=count, walking chunks from the nearer end.
+// pre: 0<=i<=length()
+List::Link* List::locate(int i, int& k) {
+    Link* N;
+
+    if( i<=num_elements/2 ) {
+        N = dummy.next;
+        k = i;
+        while( N!=&dummy && k>N->count ) {
+            k -= N->count;
+            N = N->next;
+        }
+    }
+    else {
+        // count back from the end to the chunk holding position i
+        N = &dummy;
+        k = num_elements - i;
+        while( k>0 ) {
+            N = N->prev;
+            k -= N->count;
+        }
+        k = -k;
+    }
+
+    return N;
+}
+
+// setCursor()
+// Places the cursor at position i.
+// pre: 0<=i<=length()
+void List::setCursor(int i) {
+    cursorNode = locate(i, cursorIndex);
+    pos_cursor = i;
+}
+
+// takeNodes()
+// Moves L's slabs and free Nodes into this List's pool in constant time, and
+// leaves L empty.
+void List::takeNodes(List& L) {
+#ifndef LIST_NO_NODE_POOL
+    // L's slabs go behind this List's newest slab, which keeps carving Nodes
+    if( L.slabs!=nullptr ) {
+        if( slabs==nullptr ) {
+            slabs = L.slabs;
+            slabs_tail = L.slabs_tail;
+        }
+        else {
+            L.slabs_tail->next = slabs->next;
+            slabs->next = L.slabs;
+            if( slabs_tail==slabs ) {
+                slabs_tail = L.slabs_tail;
+            }
+        }
+    }
+
+    if( L.free_nodes!=nullptr ) {
+        if( free_nodes==nullptr ) {
+            free_tail = L.free_tail;
+        }
+        L.free_tail->next = free_nodes;
+        free_nodes = L.free_nodes;
+    }
+
+    L.slabs = nullptr;
+    L.slabs_tail = nullptr;
+    L.free_nodes = nullptr;
+    L.free_tail = nullptr;
+    L.slab_nodes = LIST_FIRST_SLAB_NODES;
+#endif
+
+    L.dummy.next = &L.dummy;
+    L.dummy.prev = &L.dummy;
+    L.cursorNode = &L.dummy;
+    L.cursorIndex = 0;
+    L.pos_cursor = 0;
+    L.num_elements = 0;
+    L.chunk_index.valid = false;
+}
+
+// swapState()
+// Exchanges the elements, cursor, pool and chunk index of this List with
+// those of L. Each dummy stays with its List, so the ends of both rings are
+// relinked to their new dummy.
+void List::swapState(List& L) noexcept {
+    std::swap(dummy.next, L.dummy.next);
+    std::swap(dummy.prev, L.dummy.prev);
+    std::swap(cursorNode, L.cursorNode);
+    std::swap(cursorIndex, L.cursorIndex);
+    std::swap(pos_cursor, L.pos_cursor);
+    std::swap(num_elements, L.num_elements);
+    std::swap(slabs, L.slabs);
+    std::swap(slabs_tail, L.slabs_tail);
+    std::swap(free_nodes, L.free_nodes);
+    std::swap(free_tail, L.free_tail);
+    std::swap(slab_nodes, L.slab_nodes);
+    std::swap(chunk_index, L.chunk_index);
+
+    adoptRing(&L.dummy);
+    L.adoptRing(&dummy);
+}
+
+// adoptRing()
+// Points the ends of the ring, and the cursor if it is at the back, at this
+// List's dummy instead of old, the dummy the ring was taken from.
+void List::adoptRing(Link* old) noexcept {
+    if( dummy.next==old ) {
+        dummy.next = &dummy;
+        dummy.prev = &dummy;
+    }
+    else {
+        dummy.next->prev = &dummy;
+        dummy.prev->next = &dummy;
+    }
+    if( cursorNode==old ) {
+        cursorNode = &dummy;
+    }
+}
+
+// buildIndex()
+// Rebuilds chunk_index from the chunks of this List.
+void List::buildIndex() {
+    ChunkIndex& X = chunk_index;
+
+    int m = 0;
+    for( Link* N = dummy.next; N!=&dummy; N = N->next ) {
+        m++;
+    }
+
+    // every chunk gets a free slot after it, with more room at the back
+    int size = 2*m + m/2 + 8;
+    X.chunks.assign(size, nullptr);
+    X.tree.assign(size + 1, 0);
+
+    int s = 0;
+    for( Link* N = dummy.next; N!=&dummy; N = N->next ) {
+        N->slot = s;
+        X.chunks[s] = node(N);
+        X.tree[s + 1] = N->count;
+        s += 2;
+    }
+
+    // turn the counts into a Fenwick tree in place
+    for( int j = 1; j<=size; j++ ) {
+        int parent = j + (j & -j);
+        if( parent<=size ) {
+            X.tree[parent] += X.tree[j];
+        }
+    }
+
+    X.pending_node = nullptr;
+    X.pending = 0;
+    X.valid = true;
+}
+
+// foldPending()
+// Adds the pending count change of chunk_index into its tree.
+void List::foldPending() {
+    ChunkIndex& X = chunk_index;
+    int size = int(X.chunks.size());
+
+    if( X.pending!=0 ) {
+        for( int j = X.pending_node->slot + 1; j<=size; j += j & -j ) {
+            X.tree[j] += X.pending;
+        }
+        X.pending = 0;
+    }
+}
+
+// addCount()
+// Records in chunk_index that the count of chunk N changed by d.
+void List::addCount(Node* N, int d) {
+    ChunkIndex& X = chunk_index;
+
+    if( !X.valid ) {
+        return;
+    }
+
+    // edits at the cursor stay O(1) until it moves to another chunk
+    if( N!=X.pending_node ) {
+        if( X.pending_node!=nullptr ) {
+            foldPending();
+        }
+        X.pending_node = N;
+    }
+    X.pending += d;
+}
+
+// moveSlot()
+// Moves chunk N to the free slot s of chunk_index.
+// pre: no count change is pending
+void List::moveSlot(Node* N, int s) {
+    ChunkIndex& X = chunk_index;
+    int size = int(X.chunks.size());
+
+    for( int j = N->slot + 1; j<=size; j += j & -j ) {
+        X.tree[j] -= N->count;
+    }
+    for( int j = s + 1; j<=size; j += j & -j ) {
+        X.tree[j] += N->count;
+    }
+
+    X.chunks[N->slot] = nullptr;
+    X.chunks[s] = N;
+    N->slot = s;
 }
 
+// freeSlot()
+// Frees a slot between the chunks in slots before and after, shifting
+// nearby chunks over by one slot if needed. Returns the slot, or -1 if
+// there is no free slot near enough.
+int List::freeSlot(int before, int after) {
+    ChunkIndex& X = chunk_index;
+    int size = int(X.chunks.size());
+
+    if( after - before>1 ) {
+        return before + 1;
+    }
+
+    foldPending();
+
+    // shift the chunks from after up to the nearest free slot above
+    for( int f = after + 1; f<size && f<=after + LIST_SLOT_WINDOW; f++ ) {
+        if( X.chunks[f]==nullptr ) {
+            for( int s = f - 1; s>=after; s-- ) {
+                moveSlot(X.chunks[s], s + 1);
+            }
+            return after;
+        }
+    }
+
+    // or the chunks up to before down to the nearest free slot below
+    for( int f = before - 1; f>=0 && f>=before - LIST_SLOT_WINDOW; f-- ) {
+        if( X.chunks[f]==nullptr ) {
+            for( int s = f + 1; s<=before; s++ ) {
+                moveSlot(X.chunks[s], s - 1);
+            }
+            return before;
+        }
+    }
+
+    return -1;
+}
 
 // Class Constructors & Destructors -------------------------------------------
 
 // Creates new List in the empty state.
 // cursor position and number of elements are set to 0 to represent an empty list
-// when the list is empty, both 'frontDummy' and 'backDummy' point to each other
-// ^and the 'beforeCursor' and 'afterCursor' pointes are set to these dummy nodes
-// when elements are added, they are inserted in between 'frontDummy' and 'backDummy'
+// when the list is empty, 'dummy' points to itself both ways and the cursor
+// stands at the start of it
+// when elements are added, they are stored in chunks linked in between
+// 'dummy' and itself
 List::List() {
-    frontDummy = new Node(0);
-    backDummy = new Node(0);
+    dummy.next = &dummy;
+    dummy.prev = &dummy;
 
-    beforeCursor = frontDummy;
-    afterCursor = backDummy;
+    cursorNode = &dummy;
+    cursorIndex = 0;
 
     pos_cursor = 0;
     num_elements = 0;
 
-    frontDummy->next = backDummy;
-    backDummy->prev = frontDummy;
+    slabs = nullptr;
+    slabs_tail = nullptr;
+    free_nodes = nullptr;
+    free_tail = nullptr;
+    slab_nodes = LIST_FIRST_SLAB_NODES;
 }
 
 // Copy constructor.
 List::List(const List& L) {
     // make this an empty List
-    frontDummy = new Node(0);
-    backDummy = new Node(0);
+    dummy.next = &dummy;
+    dummy.prev = &dummy;
 
-    beforeCursor = frontDummy;
-    afterCursor = backDummy;
+    cursorNode = &dummy;
+    cursorIndex = 0;
 
     pos_cursor = 0;
     num_elements = 0;
 
-    frontDummy->next = backDummy;
-    backDummy->prev = frontDummy;
+    slabs = nullptr;
+    slabs_tail = nullptr;
+    free_nodes = nullptr;
+    free_tail = nullptr;
+    slab_nodes = LIST_FIRST_SLAB_NODES;
 
-    Node* curr = L.frontDummy->next;
-
-    // load elements of L into this List
-    while(curr != L.backDummy) {
-        this->insertBefore(curr->data);
-        curr = curr->next;
+    // take room for all of L's chunks in one slab
+    int chunks = 0;
+    for( Link* curr = L.dummy.next; curr!=&L.dummy; curr = curr->next ) {
+        chunks++;
     }
+    reserveNodes(chunks);
+
+    // copy L chunk by chunk, leaving the cursor at the back
+    for( Link* curr = L.dummy.next; curr!=&L.dummy; curr = curr->next ) {
+        Node* N = newNode();
+        std::copy(node(curr)->data, node(curr)->data + curr->count, N->data);
+        N->count = curr->count;
+        linkNode(N, dummy.prev);
+    }
+
+    pos_cursor = L.num_elements;
+    num_elements = L.num_elements;
+}
+
+// Move constructor.
+// Takes over the elements and cursor of L without copying them, in constant
+// time. L is left as an empty List.
+List::List(List&& L) noexcept {
+    // make this an empty List, then trade places with L
+    dummy.next = &dummy;
+    dummy.prev = &dummy;
+
+    cursorNode = &dummy;
+    cursorIndex = 0;
+
+    pos_cursor = 0;
+    num_elements = 0;
+
+    slabs = nullptr;
+    slabs_tail = nullptr;
+    free_nodes = nullptr;
+    free_tail = nullptr;
+    slab_nodes = LIST_FIRST_SLAB_NODES;
+
+    swapState(L);
 }
 
 // Destructor
 List::~List() {
     // clear the list
     clear();
-    delete frontDummy;
-    delete backDummy;
+    releaseSlabs(false);
 }
 
 
@@ -92,8 +655,8 @@ ListElement List::front() const {
     if( num_elements<=0 ) {
         throw std::runtime_error("List: front(): empty List\n");
     }
-    
-    return frontDummy->next->data;
+
+    return node(dummy.next)->data[0];
 }
 
 // back()
@@ -105,7 +668,9 @@ ListElement List::back() const {
         throw std::runtime_error("List: back(): empty List\n");
     }
 
-    return backDummy->prev->data;
+    Node* N = node(dummy.prev);
+
+    return N->data[N->count - 1];
 }
 
 // position()
@@ -119,7 +684,11 @@ int List::position() const {
 // pre: position()<length()
 ListElement List::peekNext() const {
     if( pos_cursor < num_elements ) {
-        return afterCursor->data;
+        // at the end of a chunk, the element is the first of the next one
+        if( cursorIndex==cursorNode->count ) {
+            return node(cursorNode->next)->data[0];
+        }
+        return node(cursorNode)->data[cursorIndex];
     }
     // handle the case where the cursor is at the back of the list
     else {
@@ -132,7 +701,12 @@ ListElement List::peekNext() const {
 // pre: position()>0
 ListElement List::peekPrev() const {
     if( pos_cursor > 0 ) {
-        return beforeCursor->data;
+        // at the start of a chunk, the element is the last of the previous one
+        if( cursorIndex==0 ) {
+            Node* N = node(cursorNode->prev);
+            return N->data[N->count - 1];
+        }
+        return node(cursorNode)->data[cursorIndex - 1];
     }
     // handle the case where the cursor is at the front of the list
     else {
@@ -146,11 +720,24 @@ ListElement List::peekPrev() const {
 // clear()
 // Deletes all elements in this List, setting it to the empty state.
 void List::clear() {
-    moveFront();
-    while(frontDummy->next != backDummy) {
-        eraseAfter();
-        moveFront();
+#ifdef LIST_NO_NODE_POOL
+    Link* curr = dummy.next;
+    while(curr != &dummy) {
+        Link* next = curr->next;
+        freeNode(node(curr));
+        curr = next;
     }
+#else
+    // every Node lives in a slab, so drop them all at once, keeping the
+    // newest slab for the elements inserted next
+    releaseSlabs(true);
+#endif
+
+    dummy.next = &dummy;
+    dummy.prev = &dummy;
+    num_elements = 0;
+    chunk_index.valid = false;
+    moveFront();
 
     pos_cursor = 0;
 }
@@ -159,16 +746,16 @@ void List::clear() {
 // Moves cursor to position 0 in this List.
 void List::moveFront() {
     pos_cursor = 0;
-    afterCursor = frontDummy->next;
-    beforeCursor = frontDummy;
+    cursorNode = dummy.next;
+    cursorIndex = 0;
 }
 
 // moveBack()
 // Moves cursor to position length() in this List.
 void List::moveBack() {
     pos_cursor = num_elements;
-    beforeCursor = backDummy->prev;
-    afterCursor = backDummy;
+    cursorNode = &dummy;
+    cursorIndex = 0;
 }
 
 // moveNext()
@@ -177,12 +764,14 @@ void List::moveBack() {
 // Pre: position() < length()
 ListElement List::moveNext() {
     if( pos_cursor < num_elements ) {
-        afterCursor = afterCursor->next;
-        beforeCursor = beforeCursor->next;
-        
+        if( cursorIndex==cursorNode->count ) {
+            cursorNode = cursorNode->next;
+            cursorIndex = 0;
+        }
+
         pos_cursor++;
 
-        return beforeCursor->data;
+        return node(cursorNode)->data[cursorIndex++];
     }
     // handle the case where the cursor is at the back of the list
     else {
@@ -196,12 +785,14 @@ ListElement List::moveNext() {
 // Pre: position() > 0
 ListElement List::movePrev() {
     if( pos_cursor > 0 ) {
-        afterCursor = afterCursor->prev;
-        beforeCursor = beforeCursor->prev;
-        
+        if( cursorIndex==0 ) {
+            cursorNode = cursorNode->prev;
+            cursorIndex = cursorNode->count;
+        }
+
         pos_cursor--;
 
-        return afterCursor->data;
+        return node(cursorNode)->data[--cursorIndex];
     }
     // handle the case where the cursor is at the front of the list
     else {
@@ -209,34 +800,84 @@ ListElement List::movePrev() {
     }
 }
 
+// moveTo()
+// Moves cursor to position i in this List in O(log n) time. The chunks
+// are first reindexed, in O(n/CHUNK) time, if a new chunk found no free
+// slot near it or Lists were spliced since the last call.
+// pre: 0<=i<=length()
+void List::moveTo(int i) {
+    if( i<0 || i>num_elements ) {
+        throw std::runtime_error("List: moveTo(): position out of range\n");
+    }
+
+    if( !chunk_index.valid ) {
+        buildIndex();
+    }
+    foldPending();
+
+    if( i==0 ) {
+        moveFront();
+        return;
+    }
+
+    // descend the Fenwick tree to the first slot whose elements, with all
+    // before it, reach position i
+    ChunkIndex& X = chunk_index;
+    int size = int(X.chunks.size());
+    int j = 0;
+    int k = i;
+    int step = 1;
+    while( step*2<=size ) {
+        step *= 2;
+    }
+    for( ; step>0; step /= 2 ) {
+        if( j + step<=size && X.tree[j + step]<k ) {
+            j += step;
+            k -= X.tree[j];
+        }
+    }
+
+    cursorNode = X.chunks[j];
+    cursorIndex = k;
+    pos_cursor = i;
+}
+
 // insertAfter()
 // Inserts x after the cursor.
 void List::insertAfter(ListElement x) {
-    Node* new_node = new Node(x);               // create a new node with x
-    
-    // adjust pointers to link the new node after the cursor
-    new_node->next = afterCursor;
-    new_node->prev = beforeCursor;
-    
-    afterCursor->prev = new_node;               // update the previous node's next pointer to the new node
-    beforeCursor->next = new_node;              // update the node before the cursor's next pointer to point to the new node
-    afterCursor = new_node;                     // move the cursor forward to the new node
-    
+    makeRoom();                                 // find a chunk with a free slot at the cursor
+
+    Node* N = node(cursorNode);
+
+    // shift the rest of the chunk up and store x after the cursor
+    if( cursorIndex<N->count ) {
+        std::copy_backward(N->data + cursorIndex, N->data + N->count, N->data + N->count + 1);
+    }
+    N->data[cursorIndex] = x;
+    N->count++;
+    if( chunk_index.valid ) {
+        addCount(N, 1);
+    }
+
     num_elements++;                             // increment num_elements
 }
 
 // insertBefore()
 // Inserts x before the cursor.
 void List::insertBefore(ListElement x) {
-    Node* new_node = new Node(x);               // create a new node with x
+    makeRoom();                                 // find a chunk with a free slot at the cursor
 
-    // adjust pointers to link the new node before the cursor
-    new_node->next = afterCursor;
-    new_node->prev = beforeCursor;
+    Node* N = node(cursorNode);
 
-    afterCursor->prev = new_node;               // update the next node's previous pointer to point to the new node
-    beforeCursor->next = new_node;              // update the node before the cursor's next pointer to point to the new node
-    beforeCursor = new_node;                    // move the cursor backward to the new node
+    // shift the rest of the chunk up and store x before the cursor
+    if( cursorIndex<N->count ) {
+        std::copy_backward(N->data + cursorIndex, N->data + N->count, N->data + N->count + 1);
+    }
+    N->data[cursorIndex++] = x;
+    N->count++;
+    if( chunk_index.valid ) {
+        addCount(N, 1);
+    }
 
     num_elements++;                             // increment num_elements
     pos_cursor++;                               // increment pos_cursor
@@ -247,7 +888,12 @@ void List::insertBefore(ListElement x) {
 // Pre: position() < length()
 void List::setAfter(ListElement x) {
     if( pos_cursor < num_elements ) {
-        afterCursor->data = x;
+        if( cursorIndex==cursorNode->count ) {
+            node(cursorNode->next)->data[0] = x;
+        }
+        else {
+            node(cursorNode)->data[cursorIndex] = x;
+        }
     }
     // handle the case where the cursor is at the back of the list
     else {
@@ -260,7 +906,13 @@ void List::setAfter(ListElement x) {
 // Pre: position() > 0
 void List::setBefore(ListElement x) {
     if( pos_cursor > 0 ) {
-        beforeCursor->data = x;
+        if( cursorIndex==0 ) {
+            Node* N = node(cursorNode->prev);
+            N->data[N->count - 1] = x;
+        }
+        else {
+            node(cursorNode)->data[cursorIndex - 1] = x;
+        }
     }
     // handle the case where the cursor is at the front of the list
     else {
@@ -273,20 +925,24 @@ void List::setBefore(ListElement x) {
 // Pre: position() < length()
 void List::eraseAfter() {
     if( pos_cursor < num_elements ) {
-        // check if the node after the cursor exists
-        if( afterCursor!=nullptr ) {
-			Node* to_delete = afterCursor;      // save a pointer to the node to be deleted
+        // stand in the chunk that holds the element
+        if( cursorIndex==cursorNode->count ) {
+            cursorNode = cursorNode->next;
+            cursorIndex = 0;
+        }
 
-			afterCursor = afterCursor->next;    // update the cursor to point to the next node
-			
-            // adjust pointers to remove to_delete
-            beforeCursor->next = afterCursor;
-			afterCursor->prev = beforeCursor;
+        Node* N = node(cursorNode);
 
-			delete to_delete;                   // delete the node
+        // shift the rest of the chunk down over the element
+        std::copy(N->data + cursorIndex + 1, N->data + N->count, N->data + cursorIndex);
+        N->count--;
+        if( chunk_index.valid ) {
+            addCount(N, -1);
+        }
+
+        num_elements--;                         // decrement num_elements
 
-			num_elements--;                     // decrement num_elements
-		}
+        shrink(N);
     }
     // handle the case where the cursor is at the back of the list
     else {
@@ -299,21 +955,26 @@ void List::eraseAfter() {
 // Pre: position() > 0
 void List::eraseBefore() {
     if( pos_cursor > 0 ) {
-        // check if the node before the cursor exists
-        if( beforeCursor!=nullptr ) {
-			Node* to_delete = beforeCursor;     // save a pointer to the node to be deleted
+        // stand in the chunk that holds the element
+        if( cursorIndex==0 ) {
+            cursorNode = cursorNode->prev;
+            cursorIndex = cursorNode->count;
+        }
+
+        Node* N = node(cursorNode);
 
-			beforeCursor = beforeCursor->prev;  // update the cursor to point to the previous node
-			
-            // adjust pointers to remove to_delete
-            afterCursor->prev = beforeCursor;
-			beforeCursor->next = afterCursor;
+        // shift the rest of the chunk down over the element
+        std::copy(N->data + cursorIndex, N->data + N->count, N->data + cursorIndex - 1);
+        N->count--;
+        if( chunk_index.valid ) {
+            addCount(N, -1);
+        }
+        cursorIndex--;
 
-			delete to_delete;                   // delete the node
+        pos_cursor--;                           // decrement pos_cursor
+        num_elements--;                         // decrement num_elements
 
-			pos_cursor--;                       // decrement pos_cursor
-			num_elements--;                     // decrement num_elements
-		}
+        shrink(N);
     }
     // handle the case where the cursor is at the front of the list
     else {
@@ -321,6 +982,83 @@ void List::eraseBefore() {
     }
 }
 
+// splice()
+// Moves all elements of L into this List before position i, in order,
+// without copying them, and leaves L empty. The cursor stays between the
+// same elements; if it was at position i, the moved elements follow it.
+// Finding position i walks the chunks from the nearer end of this List, so
+// it takes time proportional to min(i, length()-i)/CHUNK and nothing at
+// the front or back; the rest takes constant time, whatever L's length.
+// pre: 0<=i<=length(), L is not this List
+void List::splice(int i, List& L) {
+    if( &L==this ) {
+        throw std::runtime_error("List: splice(): cannot splice a List into itself\n");
+    }
+    if( i<0 || i>num_elements ) {
+        throw std::runtime_error("List: splice(): position out of range\n");
+    }
+    if( L.num_elements==0 ) {
+        return;
+    }
+
+    // find the chunk P that L's chunks go after, splitting the chunk that
+    // holds position i if i falls inside it
+    int k;
+    Link* N = locate(i, k);
+    Link* P;
+
+    if( k==0 ) {
+        P = N->prev;
+    }
+    else if( k==N->count ) {
+        P = N;
+    }
+    else {
+        Node* F = node(N);
+        Node* M = newNode();
+
+        linkNode(M, F);
+        std::copy(F->data + k, F->data + F->count, M->data);
+        M->count = F->count - k;
+        F->count = k;
+
+        if( cursorNode==F && cursorIndex>k ) {
+            cursorNode = M;
+            cursorIndex -= k;
+        }
+        P = F;
+    }
+
+    // relink L's chunks between P and the chunk after it
+    Link* first = L.dummy.next;
+    Link* last = L.dummy.prev;
+
+    last->next = P->next;
+    P->next->prev = last;
+    P->next = first;
+    first->prev = P;
+    chunk_index.valid = false;
+
+    if( pos_cursor==i ) {
+        cursorNode = first;
+        cursorIndex = 0;
+    }
+    else if( pos_cursor>i ) {
+        pos_cursor += L.num_elements;
+    }
+    num_elements += L.num_elements;
+
+    takeNodes(L);
+}
+
+// splice()
+// Moves all elements of L to the back of this List without copying them,
+// and leaves L empty.
+// pre: L is not this List
+void List::splice(List&& L) {
+    splice(num_elements, L);
+}
+
 
 // Other Functions ------------------------------------------------------------
 
@@ -332,17 +1070,13 @@ void List::eraseBefore() {
 // the cursor at position length(), and returns -1.
 int List::findNext(ListElement x) {
     while(pos_cursor < num_elements) {
-		moveNext();
-		
         // if x is found
-        if( beforeCursor->data==x ) {
-			return pos_cursor;
-		}	
-	}
+        if( moveNext()==x ) {
+            return pos_cursor;
+        }
+    }
 
     // element not found, place cursor at the end
-    // afterCursor = backDummy;
-    // pos_cursor = num_elements;
     moveBack();
 
     return -1;
@@ -356,18 +1090,13 @@ int List::findNext(ListElement x) {
 // the cursor at position 0, and returns -1.
 int List::findPrev(ListElement x) {
     while(pos_cursor > 0) {
-		movePrev();
-		
         // if x is found
-        if( afterCursor->data==x) {
-			return pos_cursor;
-		}
-	
-	}
+        if( movePrev()==x ) {
+            return pos_cursor;
+        }
+    }
 
     // element not found, place cursor at the front
-    // beforeCursor = frontDummy;
-    // pos_cursor = 0;
     moveFront();
 
     return -1;
@@ -379,44 +1108,66 @@ int List::findPrev(ListElement x) {
 // occurrence of each element, and removing all other occurrences. The cursor
 // is not moved with respect to the retained elements, i.e., it lies between
 // the same two retained elements that it did before cleanup() was called.
+// Runs in one pass, in expected O(n) time.
 void List::cleanup() {
-    Node* curr = frontDummy->next;
+    int index = 0;                      // position of the element examined
+    int retained = 0;                   // elements kept so far
+    int new_cursor = 0;                 // retained elements before the cursor
 
-    while(curr != backDummy) {
-        Node* my_node = curr->next;
+    chunk_index.valid = false;
 
-        while(my_node != backDummy) {
-            if( curr->data==my_node->data ) {
-                // remove repeated element
-                my_node->prev->next = my_node->next;
-                my_node->next->prev = my_node->prev;
+    // values already kept, so each element is checked in expected O(1)
+    std::unordered_set<ListElement> seen_values;
+    seen_values.reserve(num_elements);
 
-                /*
-                // if the cursor is after the removed element, adjust position
-                if( pos_cursor > 0 && my_node == afterCursor )
-                    pos_cursor--;
-                */
+    Link* curr = dummy.next;
 
-                // if the cursor is at or after the removed element
-                if( pos_cursor >= num_elements - 1 || my_node == afterCursor ) {
-                    pos_cursor--;
-                }
+    while(curr != &dummy) {
+        Node* chunk = node(curr);
+        Link* next = curr->next;
+        int kept = 0;
 
-                // delete the node and move the my_node to the next node
-                Node* to_delete = my_node;
-                my_node = my_node->next;
+        // compact the chunk in place, keeping elements not seen before it
+        for(int i = 0; i < curr->count; i++) {
+            ListElement x = chunk->data[i];
+            bool seen = !seen_values.insert(x).second;
 
-                delete to_delete;
-
-                num_elements--;
+            if( index < pos_cursor ) {
+                new_cursor = retained + !seen;
             }
-            else {
-                my_node = my_node->next;
+            if( !seen ) {
+                chunk->data[kept++] = x;
+                retained++;
             }
+            index++;
         }
 
-        curr = curr->next;
+        chunk->count = kept;
+        if( kept==0 ) {
+            dropNode(chunk);
+        }
+
+        curr = next;
+    }
+
+    // merge neighboring chunks that now fit in one
+    curr = dummy.next;
+    while(curr != &dummy && curr->next != &dummy) {
+        Link* next = curr->next;
+
+        if( curr->count + next->count <= CHUNK ) {
+            Node* from = node(next);
+            std::copy(from->data, from->data + from->count, node(curr)->data + curr->count);
+            curr->count += from->count;
+            dropNode(from);
+        }
+        else {
+            curr = next;
+        }
     }
+
+    num_elements = retained;
+    setCursor(new_cursor);
 }
 
 // concat()
@@ -425,14 +1176,22 @@ void List::cleanup() {
 List List::concat(const List& L) const {
     List result = *this;
 
-    Node* curr_node = L.frontDummy->next;
+    // copy L chunk by chunk and link the copy in at the back of result
+    result.splice(List(L));
+    result.moveFront();
 
-    // traverse the nodes of L and insert each element before the cursor in result
-    while(curr_node != L.backDummy) {
-        result.insertBefore(curr_node->data);
-        curr_node = curr_node->next;
-    }
+    return result;
+}
 
+// concat()
+// Returns a new List consisting of the elements of this List, followed by
+// the elements of L, made by taking over the storage of both. This List and
+// L are both left empty. The cursor in the returned List will be at
+// position 0.
+List List::concat(List&& L) && {
+    List result(std::move(*this));
+
+    result.splice(std::move(L));
     result.moveFront();
 
     return result;
@@ -444,14 +1203,16 @@ List List::concat(const List& L) const {
 std::string List::to_string() const {
     std::string result = "(";
 
-    Node* curr = frontDummy->next;
+    Link* curr = dummy.next;
 
-    while(curr != backDummy) {
-        if( curr!=frontDummy->next ) {
-            result += ", ";
-        }
+    while(curr != &dummy) {
+        for(int i = 0; i < curr->count; i++) {
+            if( curr!=dummy.next || i>0 ) {
+                result += ", ";
+            }
 
-        result += std::to_string(curr->data);
+            result += std::to_string(node(curr)->data[i]);
+        }
         curr = curr->next;
     }
 
@@ -469,18 +1230,33 @@ bool List::equals(const List& R) const {
         return false;
     }
 
-    Node* curr_this = frontDummy->next;
-    Node* curr_R = R.frontDummy->next;
+    Link* curr_this = dummy.next;
+    Link* curr_R = R.dummy.next;
+    int i_this = 0;
+    int i_R = 0;
 
-    // traverse until the end of either list is reached
-    while(curr_this != backDummy && curr_R != R.backDummy) {
-        // check if the data in the current nodes of both lists are equal
-        if( curr_this->data!=curr_R->data ) {
+    // the two Lists may be chunked differently, so walk both element by element
+    while(curr_this != &dummy && curr_R != &R.dummy) {
+        // compare the run that both current chunks still hold
+        int run = std::min(curr_this->count - i_this, curr_R->count - i_R);
+
+        ListElement* run_this = node(curr_this)->data + i_this;
+
+        if( !std::equal(run_this, run_this + run, node(curr_R)->data + i_R) ) {
             return false;
         }
 
-        curr_this = curr_this->next;
-        curr_R = curr_R->next;
+        i_this += run;
+        i_R += run;
+
+        if( i_this==curr_this->count ) {
+            curr_this = curr_this->next;
+            i_this = 0;
+        }
+        if( i_R==curr_R->count ) {
+            curr_R = curr_R->next;
+            i_R = 0;
+        }
     }
 
     // if all elements are checked and equal, return true
@@ -509,12 +1285,18 @@ bool operator==(const List& A, const List& B) {
 List& List::operator=(const List& L) {
     if( this!=&L ) {                    // not self-assignment
         List temp = L;
-        std::swap(frontDummy, temp.frontDummy);
-        std::swap(backDummy, temp.backDummy);
-        std::swap(beforeCursor, temp.beforeCursor);
-        std::swap(afterCursor, temp.afterCursor);
-        std::swap(pos_cursor, temp.pos_cursor);
-        std::swap(num_elements, temp.num_elements);
+        swapState(temp);
+    }
+
+    return *this;
+}
+
+// operator=()
+// Overwrites the state of this List with state of L by exchanging storage
+// with it. L takes over the previous contents of this List.
+List& List::operator=(List&& L) noexcept {
+    if( this!=&L ) {
+        swapState(L);
     }
 
     return *this;
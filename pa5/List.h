@@ -4,13 +4,22 @@
 // cursor standing between elements. The cursor position is always defined
 // to be an int in the range 0 (at front) to length of List (at back).
 // An empty list consists of the vertical cursor only, with no elements.
+// Elements are stored in chunks of consecutive elements (an unrolled linked
+// list), which are split when full and merged when they run low.
 //-----------------------------------------------------------------------------
 #include<iostream>
 #include<string>
+#include<vector>
 
 #ifndef List_H_INCLUDE_
 #define List_H_INCLUDE_
 
+// Size in bytes of each chunk of elements. Override with -D, identically for
+// every file that includes List.h.
+#ifndef LIST_CHUNK_BYTES
+#define LIST_CHUNK_BYTES 256
+#endif
+
 // Exported types -------------------------------------------------------------
 typedef int ListElement;
 
@@ -18,24 +27,161 @@ class List{
 
 private:
 
-   // private Node struct
-   struct Node{
+   // private Link struct, the ring fields of a Node, which alone make up the
+   // dummy at the ends of the ring
+   struct Link{
+      // Link fields
+      Link* next;
+      Link* prev;
+      int count;
+      int slot;                    // slot in the chunk index
+      // Link constructor
+      Link();
+   };
+
+   // number of elements a Node holds
+   static const int CHUNK = int((LIST_CHUNK_BYTES - sizeof(Link))/sizeof(ListElement));
+   static_assert(CHUNK>=2, "List: LIST_CHUNK_BYTES leaves room for fewer than 2 elements per chunk");
+
+   // private Node struct, a chunk of up to CHUNK consecutive elements
+   struct Node : Link{
       // Node fields
-      ListElement data;
-      Node* next;
-      Node* prev;
+      ListElement data[CHUNK];
       // Node constructor
-      Node(ListElement x);
+      Node();
    };
 
-   // List fields
-   Node* frontDummy;
-   Node* backDummy;
-   Node* beforeCursor;
-   Node* afterCursor;
+   // private Slab struct, a block of Nodes allocated at once (List.cpp)
+   struct Slab;
+
+   // private ChunkIndex struct, an index over the chunks for moveTo(). Each
+   // chunk holds a slot, in List order with free slots left between, so
+   // chunks can be split and merged without reindexing. The change to the
+   // count of pending_node not yet added into tree is held in pending.
+   struct ChunkIndex{
+      std::vector<Node*> chunks;   // chunk in each slot, or nullptr
+      std::vector<int> tree;       // Fenwick tree of slot counts
+      bool valid = false;
+      Node* pending_node = nullptr;
+      int pending = 0;
+   };
+
+   // List fields: the chunks form a ring through the empty dummy Link, held
+   // in the List itself, and the cursor stands before element cursorIndex of
+   // cursorNode, where 0 <= cursorIndex <= cursorNode->count
+   Link dummy;
+   Link* cursorNode;
+   int cursorIndex;
    int pos_cursor;
    int num_elements;
 
+   // Node pool fields: slabs owned by this List, newest first, the Nodes
+   // freed back to them, the last of each (set while the first is not
+   // nullptr) so takeNodes() can hand them over in constant time, and the
+   // capacity of the next slab
+   Slab* slabs;
+   Slab* slabs_tail;
+   Node* free_nodes;
+   Node* free_tail;
+   int slab_nodes;
+
+   // index over the chunks, valid only after moveTo()
+   ChunkIndex chunk_index;
+
+   // Node allocation ---------------------------------------------------------
+
+   // newNode()
+   // Returns a new empty Node, taken from this List's pool.
+   Node* newNode();
+
+   // freeNode()
+   // Returns N to this List's pool.
+   void freeNode(Node* N);
+
+   // reserveNodes()
+   // Makes room in the pool for n more Nodes without further allocation.
+   void reserveNodes(int n);
+
+   // releaseSlabs()
+   // Frees every slab, or every slab but the newest if keep is true, leaving
+   // no Nodes in use.
+   void releaseSlabs(bool keep);
+
+   // Chunk maintenance -------------------------------------------------------
+
+   // node()
+   // Returns the Node whose ring fields are N.
+   // pre: N is not the dummy
+   static Node* node(Link* N);
+
+   // linkNode()
+   // Links N into the ring after P.
+   void linkNode(Node* N, Link* P);
+
+   // dropNode()
+   // Unlinks N from the ring and returns it to the pool.
+   void dropNode(Node* N);
+
+   // makeRoom()
+   // Moves the cursor to an equivalent place in a chunk with a free slot,
+   // starting or splitting a chunk if there is none.
+   void makeRoom();
+
+   // shrink()
+   // Frees the cursor's chunk N if it is empty, or merges it with a neighbor
+   // if it is less than half full and both fit in one chunk.
+   void shrink(Node* N);
+
+   // locate()
+   // Returns the chunk holding position i and sets k to the offset of i in
+   // it, 0<=k<=count, walking chunks from the nearer end.
+   // pre: 0<=i<=length()
+   Link* locate(int i, int& k);
+
+   // setCursor()
+   // Places the cursor at position i.
+   // pre: 0<=i<=length()
+   void setCursor(int i);
+
+   // takeNodes()
+   // Moves L's slabs and free Nodes into this List's pool in constant time,
+   // and leaves L empty.
+   void takeNodes(List& L);
+
+   // swapState()
+   // Exchanges the elements, cursor, pool and chunk index of this List with
+   // those of L. Each dummy stays with its List, so the ends of both rings
+   // are relinked to their new dummy.
+   void swapState(List& L) noexcept;
+
+   // adoptRing()
+   // Points the ends of the ring, and the cursor if it is at the back, at
+   // this List's dummy instead of old, the dummy the ring was taken from.
+   void adoptRing(Link* old) noexcept;
+
+   // buildIndex()
+   // Rebuilds chunk_index from the chunks of this List.
+   void buildIndex();
+
+   // foldPending()
+   // Adds the pending count change of chunk_index into its tree.
+   void foldPending();
+
+   // addCount()
+   // Records in chunk_index that the count of chunk N changed by d.
+   void addCount(Node* N, int d);
+
+   // moveSlot()
+   // Moves chunk N to the free slot s of chunk_index.
+   // pre: no count change is pending
+   void moveSlot(Node* N, int s);
+
+   // freeSlot()
+   // Frees a slot between the chunks in slots before and after, shifting
+   // nearby chunks over by one slot if needed. Returns the slot, or -1 if
+   // there is no free slot near enough.
+   int freeSlot(int before, int after);
+
 public:
 
    // Class Constructors & Destructors ----------------------------------------
@@ -46,6 +192,11 @@ public:
    // Copy constructor.
    List(const List& L);
 
+   // Move constructor.
+   // Takes over the elements and cursor of L without copying them, in
+   // constant time. L is left as an empty List.
+   List(List&& L) noexcept;
+
    // Destructor
    ~List();
 
@@ -107,6 +258,13 @@ public:
    // pre: position()>0
    ListElement movePrev();
 
+   // moveTo()
+   // Moves cursor to position i in this List in O(log n) time. The chunks
+   // are first reindexed, in O(n/CHUNK) time, if a new chunk found no free
+   // slot near it or Lists were spliced since the last call.
+   // pre: 0<=i<=length()
+   void moveTo(int i);
+
    // insertAfter()
    // Inserts x after cursor.
    void insertAfter(ListElement x);
@@ -135,6 +293,22 @@ public:
    // pre: position()>0
    void eraseBefore();
 
+   // splice()
+   // Moves all elements of L into this List before position i, in order,
+   // without copying them, and leaves L empty. The cursor stays between the
+   // same elements; if it was at position i, the moved elements follow it.
+   // Finding position i walks the chunks from the nearer end of this List,
+   // so it takes time proportional to min(i, length()-i)/CHUNK and nothing
+   // at the front or back; the rest takes constant time, whatever L's length.
+   // pre: 0<=i<=length(), L is not this List
+   void splice(int i, List& L);
+
+   // splice()
+   // Moves all elements of L to the back of this List without copying them,
+   // and leaves L empty.
+   // pre: L is not this List
+   void splice(List&& L);
+
 
    // Other Functions ---------------------------------------------------------
 
@@ -167,6 +341,13 @@ public:
    // the elements of L. The cursor in the returned List will be at postion 0.
    List concat(const List& L) const;
 
+   // concat()
+   // Returns a new List consisting of the elements of this List, followed by
+   // the elements of L, made by taking over the storage of both. This List
+   // and L are both left empty. The cursor in the returned List will be at
+   // position 0.
+   List concat(List&& L) &&;
+
    // to_string()
    // Returns a string representation of this List consisting of a comma 
    // separated sequence of elements, surrounded by parentheses.
@@ -193,6 +374,11 @@ public:
    // Overwrites the state of this List with state of L.
    List& operator=( const List& L );
 
+   // operator=()
+   // Overwrites the state of this List with state of L by exchanging storage
+   // with it. L takes over the previous contents of this List.
+   List& operator=( List&& L ) noexcept;
+
 };
 
 
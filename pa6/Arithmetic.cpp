@@ -4,65 +4,277 @@
 // Arithmetic.cpp
 // pa6
 // Top-level client for BigInteger ADT
+//
+// Usage: Arithmetic <input file> <output file>
+//        Arithmetic --batch [--threads T] [--window W] <input file> <output file>
+//
+// The first form reads one pair A, B and writes the expression set below.
+// The batch form streams any number of pairs from the input, evaluates them
+// on T worker threads (default: one per hardware thread) and writes each
+// pair's results in input order. At most W pairs (default 1024) are read
+// but not yet written at any time, which bounds memory use.
 //-----------------------------------------------------------------------------
 
 #include<iostream>
 #include<fstream>
+#include<sstream>
 #include<string>
+#include<vector>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<cstdlib>
+#include<algorithm>
 #include"BigInteger.h"
+#include"BigIntegerExpr.h"
 
 using namespace std;
 
-int main(int argc, char* argv[]) {
-    // error message
-    if( argc!=3 ){
-        cerr << "Usage: " << argv[0] << " <input file> <output file>" << endl;
-        return(EXIT_FAILURE);
-    }
-
-    // open files
-    ifstream in(argv[1]);
-    ofstream out(argv[2]);
-
-    // read in strings
-    string str_A, str_B;
-    in >> str_A;
-    in >> str_B;
-
-    // make BigInteger objects
-    BigInteger A = BigInteger(str_A);
-    BigInteger B = BigInteger(str_B);
-    
-    // write lines to out
+// writeExpressions()
+// Writes A, B and the values of the eight expressions on them to out, each
+// followed by a blank line.
+void writeExpressions(ostream& out, const BigInteger& A, const BigInteger& B) {
     // A
-    out << A << endl << endl;
+    out << A << "\n\n";
 
     // B
-    out << B << endl << endl;
+    out << B << "\n\n";
 
     // A + B
-    out << A + B << endl << endl;
+    out << A + B << "\n\n";
 
     // A - B
-    out << A - B << endl << endl;
+    out << A - B << "\n\n";
 
     // A - A
-    out << A - A << endl << endl;
+    out << A - A << "\n\n";
 
-    // 3*A - 2*B
-    out << A.mult(BigInteger("3")) - B.mult(BigInteger("2")) << endl << endl;
+    // 3*A - 2*B, scaled and summed in one pass
+    BigInteger C = 3*lazy(A) - 2*lazy(B);
+    out << C << "\n\n";
 
     // A*B
-    out << A * B << endl << endl;
+    out << A * B << "\n\n";
 
     // A*A
-    out << A * A << endl << endl;
+    BigInteger A2 = A * A;
+    out << A2 << "\n\n";
 
     // B*B
-    out << B * B << endl << endl;
+    BigInteger B2 = B * B;
+    out << B2 << "\n\n";
+
+    // 9*(A^4) + 16*(B^5), with A^4 = (A^2)^2 and B^5 = (B^2)^2*B: the two
+    // products are formed once, then scaled and summed in one pass
+    BigInteger D = 9*lazy(A2)*lazy(A2) + 16*lazy(B2)*lazy(B2)*lazy(B);
+    out << D << "\n\n";
+}
+
+// Slot
+// One pair in the window of a batch run: its input strings, and its output
+// once a worker has evaluated it.
+struct Slot {
+    string str_A, str_B;
+    string result;
+    string error;               // non-empty if the pair could not be evaluated
+    bool done;
+};
+
+// runBatch()
+// Streams pairs from in, evaluates them on threads workers with at most
+// window pairs in flight, and writes the results to out in input order.
+// Returns false, after reporting on cerr, if the input has an odd number of
+// values or a value is not a valid integer.
+bool runBatch(istream& in, ostream& out, size_t threads, size_t window) {
+    vector<Slot> slots(window);
+    mutex lock;
+    condition_variable changed;
+    size_t read = 0;            // pairs placed in the window
+    size_t taken = 0;           // pairs handed to a worker
+    size_t written = 0;         // pairs written to out
+    bool finished = false;      // no more pairs will be read
+    bool ok = true;
+
+    // workers evaluate pairs in the order they were read
+    auto work = [&]() {
+        unique_lock<mutex> guard(lock);
+
+        for( ;; ) {
+            changed.wait(guard, [&] { return taken < read || finished; });
+            if( taken==read ) {
+                return;
+            }
+
+            Slot& slot = slots[taken++ % window];
+            guard.unlock();
+
+            ostringstream result;
+            try {
+                writeExpressions(result, BigInteger(slot.str_A), BigInteger(slot.str_B));
+                slot.result = result.str();
+            }
+            catch( const std::exception& e ) {
+                slot.error = e.what();
+            }
+
+            guard.lock();
+            slot.done = true;
+            changed.notify_all();
+        }
+    };
+
+    vector<thread> workers;
+    for( size_t i = 0; i < threads; i++ ) {
+        workers.emplace_back(work);
+    }
+
+    // writes every finished pair at the front of the window; called with
+    // the lock held
+    auto drain = [&](unique_lock<mutex>& guard) {
+        while( ok && written < read && slots[written % window].done ) {
+            Slot& slot = slots[written % window];
+
+            if( !slot.error.empty() ) {
+                cerr << "Arithmetic: pair " << written + 1 << ": " << slot.error << endl;
+                ok = false;
+                break;
+            }
+
+            string result = std::move(slot.result);
+            slot.done = false;
+            written++;
+            changed.notify_all();
+
+            guard.unlock();
+            out << result;
+            guard.lock();
+        }
+    };
+
+    string str_A, str_B;
+    unique_lock<mutex> guard(lock);
+
+    while( ok ) {
+        guard.unlock();
+        bool got_A = static_cast<bool>(in >> str_A);
+        bool got_B = got_A && static_cast<bool>(in >> str_B);
+        guard.lock();
+
+        if( !got_A ) {
+            break;
+        }
+        if( !got_B ) {
+            cerr << "Arithmetic: odd number of values in input" << endl;
+            ok = false;
+            break;
+        }
+
+        // wait for room in the window, writing results as they come in
+        drain(guard);
+        while( ok && read - written==window ) {
+            changed.wait(guard);
+            drain(guard);
+        }
+
+        Slot& slot = slots[read % window];
+        slot.str_A.swap(str_A);
+        slot.str_B.swap(str_B);
+        slot.result.clear();
+        slot.error.clear();
+        slot.done = false;
+        read++;
+        changed.notify_all();
+    }
 
-    // 9*(A^4) + 16*(B^5)
-    out << (A * A * A * A).mult(BigInteger("9")) + (B * B * B * B * B).mult(BigInteger("16")) << endl << endl;
+    // no more input: finish the pairs still in flight
+    finished = true;
+    changed.notify_all();
+
+    drain(guard);
+    while( ok && written < read ) {
+        changed.wait(guard);
+        drain(guard);
+    }
+
+    guard.unlock();
+    for( thread& t : workers ) {
+        t.join();
+    }
+
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    bool batch = false;
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t window = 1024;
+    int arg = 1;
+
+    // read options
+    for( ; arg < argc && argv[arg][0]=='-' && argv[arg][1]=='-'; arg++ ) {
+        string opt = argv[arg];
+
+        if( opt=="--batch" ) {
+            batch = true;
+        }
+        else if( opt=="--threads" && arg + 1 < argc ) {
+            threads = std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if( opt=="--window" && arg + 1 < argc ) {
+            window = std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else {
+            break;
+        }
+    }
+
+    // error message
+    if( argc - arg!=2 || threads==0 || window==0 ){
+        cerr << "Usage: " << argv[0] << " <input file> <output file>" << endl;
+        cerr << "       " << argv[0] << " --batch [--threads T] [--window W] <input file> <output file>" << endl;
+        return(EXIT_FAILURE);
+    }
+
+    // open files, giving out a large buffer since batch runs write many
+    // small results
+    vector<char> buffer(1 << 20);
+    ifstream in(argv[arg]);
+    ofstream out;
+
+    if( !in.is_open() ){
+        cerr << "Unable to open file " << argv[arg] << " for reading" << endl;
+        return(EXIT_FAILURE);
+    }
+
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    out.open(argv[arg + 1]);
+
+    if( !out.is_open() ){
+        cerr << "Unable to open file " << argv[arg + 1] << " for writing" << endl;
+        return(EXIT_FAILURE);
+    }
+
+    if( batch ) {
+        // the pairs are the unit of parallelism: keep each product serial
+        BigInteger::setMultThreads(1);
+
+        if( !runBatch(in, out, threads, window) ) {
+            return(EXIT_FAILURE);
+        }
+    }
+    else {
+        // read in strings
+        string str_A, str_B;
+        in >> str_A;
+        in >> str_B;
+
+        // make BigInteger objects
+        BigInteger A = BigInteger(str_A);
+        BigInteger B = BigInteger(str_B);
+
+        // write lines to out
+        writeExpressions(out, A, B);
+    }
 
     // close files
     in.close();
@@ -0,0 +1,285 @@
+//-----------------------------------------------------------------------------
+// Mia Santos (miesanto)
+// CSE 101 Fall 2023
+// Benchmark.cpp
+// pa6
+// Micro-benchmark and regression harness for BigInteger ADT. Sweeps operand
+// sizes from 1 limb up to 10^6 limbs for add, sub, mult, compare, to_string
+// and parse, and reports ns/op, limbs/sec and heap allocations per op. The
+// results can be recorded to a baseline file, and a later run compared
+// against it: any operation slower than the baseline by more than the
+// tolerance, or allocating more, is reported and the run exits non-zero.
+//
+// Usage: Benchmark [--max-limbs N] [--threads T] [--record <file>]
+//                  [--baseline <file>] [--tolerance <percent>]
+//-----------------------------------------------------------------------------
+
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<iomanip>
+#include<string>
+#include<vector>
+#include<map>
+#include<random>
+#include<chrono>
+#include<atomic>
+#include<cstdlib>
+#include<new>
+#include"BigInteger.h"
+
+using namespace std;
+
+// Allocation counting --------------------------------------------------------
+
+// Every heap allocation in the process goes through these replacements, so
+// allocations can be counted around each measured batch.
+static std::atomic<long> allocations(0);
+
+void* operator new(size_t n) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(n ? n : 1);
+    if( p==nullptr ) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t n) {
+    return operator new(n);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+
+// Measurement ----------------------------------------------------------------
+
+const int DIGITS_PER_LIMB = 9;
+const double BATCH_SECONDS = 0.02;      // target length of one timed batch
+const int BATCHES = 5;                  // best of this many batches is kept
+
+// Result
+// One row of the report: the best ns/op over the batches and the
+// allocations per op.
+struct Result {
+    double ns;
+    double allocs;
+};
+
+volatile long sink;                     // keeps results observable
+
+// randomDigits()
+// Returns a string of limbs*9 decimal digits with a non-zero leading digit.
+string randomDigits(mt19937_64& gen, size_t limbs) {
+    string s(limbs*DIGITS_PER_LIMB, '0');
+
+    s[0] = (char)('1' + gen() % 9);
+    for( size_t i = 1; i < s.size(); i++ ) {
+        s[i] = (char)('0' + gen() % 10);
+    }
+
+    return s;
+}
+
+// measure()
+// Times op, which performs one operation, in batches sized to take about
+// BATCH_SECONDS each, and returns the best batch's ns/op together with the
+// allocations per op.
+template<class Op>
+Result measure(Op op) {
+    using clock = std::chrono::steady_clock;
+
+    // warm up, and size the batch from one call
+    clock::time_point start = clock::now();
+    op();
+    double once = std::chrono::duration<double>(clock::now() - start).count();
+    long reps = (once > 0) ? (long)(BATCH_SECONDS/once) : 1000000;
+    reps = std::max(1L, std::min(reps, 1000000L));
+
+    Result best = { -1, 0 };
+
+    for( int b = 0; b < BATCHES; b++ ) {
+        long before = allocations.load();
+        start = clock::now();
+
+        for( long i = 0; i < reps; i++ ) {
+            op();
+        }
+
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count()/reps;
+        double allocs = (double)(allocations.load() - before)/reps;
+
+        if( best.ns < 0 || ns < best.ns ) {
+            best = { ns, allocs };
+        }
+    }
+
+    return best;
+}
+
+
+// Baseline files -------------------------------------------------------------
+
+// Baseline files hold one line per measurement, "<op> <limbs> <ns/op>
+// <allocs/op>", with '#' starting a comment line.
+
+// readBaseline()
+// Reads the baseline file at path into base, keyed by "op limbs". Returns
+// false if the file cannot be opened.
+bool readBaseline(const string& path, map<string, Result>& base) {
+    ifstream in(path);
+    string line;
+
+    if( !in ) {
+        return false;
+    }
+
+    while( getline(in, line) ) {
+        istringstream fields(line);
+        string op;
+        size_t limbs;
+        Result r;
+
+        if( line.empty() || line[0]=='#' ) {
+            continue;
+        }
+        if( fields >> op >> limbs >> r.ns >> r.allocs ) {
+            base[op + " " + std::to_string(limbs)] = r;
+        }
+    }
+
+    return true;
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t max_limbs = 1000000;
+    double tolerance = 25;
+    string record_path, baseline_path;
+
+    // read options
+    for( int i = 1; i < argc; i++ ) {
+        string arg = argv[i];
+
+        if( i + 1 < argc && arg=="--max-limbs" ) {
+            max_limbs = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if( i + 1 < argc && arg=="--threads" ) {
+            BigInteger::setMultThreads(std::atoi(argv[++i]));
+        }
+        else if( i + 1 < argc && arg=="--record" ) {
+            record_path = argv[++i];
+        }
+        else if( i + 1 < argc && arg=="--baseline" ) {
+            baseline_path = argv[++i];
+        }
+        else if( i + 1 < argc && arg=="--tolerance" ) {
+            tolerance = std::atof(argv[++i]);
+        }
+        else {
+            // error message
+            cerr << "Usage: " << argv[0] << " [--max-limbs N] [--threads T] [--record <file>]"
+                 << " [--baseline <file>] [--tolerance <percent>]" << endl;
+            return(EXIT_FAILURE);
+        }
+    }
+
+    map<string, Result> base;
+    if( !baseline_path.empty() && !readBaseline(baseline_path, base) ) {
+        cerr << "Benchmark: cannot read baseline file " << baseline_path << endl;
+        return(EXIT_FAILURE);
+    }
+
+    ofstream record;
+    if( !record_path.empty() ) {
+        record.open(record_path);
+        if( !record ) {
+            cerr << "Benchmark: cannot write " << record_path << endl;
+            return(EXIT_FAILURE);
+        }
+        record << "# op limbs ns/op allocs/op" << endl;
+    }
+
+    mt19937_64 gen(101);
+    vector<string> regressions;
+
+    cout << left << setw(10) << "op" << right << setw(10) << "limbs" << setw(16) << "ns/op"
+         << setw(16) << "limbs/sec" << setw(12) << "allocs/op" << setw(12) << "vs base" << endl;
+
+    for( size_t limbs = 1; limbs <= max_limbs; limbs *= 10 ) {
+        string sa = randomDigits(gen, limbs);
+        string sb = randomDigits(gen, limbs);
+        BigInteger A(sa), B(sb);
+        BigInteger A1 = A + BigInteger(1);      // differs from A only in the lowest limb
+
+        vector<pair<string, Result>> rows;
+
+        rows.push_back({ "add", measure([&] { BigInteger C = A + B; sink = C.sign(); }) });
+        rows.push_back({ "sub", measure([&] { BigInteger C = A - B; sink = C.sign(); }) });
+        rows.push_back({ "mult", measure([&] { BigInteger C = A * B; sink = C.sign(); }) });
+        rows.push_back({ "compare", measure([&] { sink = A.compare(A1); }) });
+        rows.push_back({ "to_string", measure([&] { sink = (long)A.to_string().size(); }) });
+        rows.push_back({ "parse", measure([&] { BigInteger C(sa); sink = C.sign(); }) });
+
+        for( const pair<string, Result>& row : rows ) {
+            const string& op = row.first;
+            const Result& r = row.second;
+            string key = op + " " + std::to_string(limbs);
+
+            cout << left << setw(10) << op << right << setw(10) << limbs
+                 << setw(16) << fixed << setprecision(1) << r.ns
+                 << setw(16) << scientific << setprecision(3) << limbs/(r.ns*1e-9)
+                 << setw(12) << fixed << setprecision(2) << r.allocs;
+
+            // compare against the baseline
+            auto it = base.find(key);
+            if( it != base.end() ) {
+                double change = 100*(r.ns - it->second.ns)/it->second.ns;
+                bool slower = change > tolerance;
+                bool more_allocs = r.allocs > it->second.allocs + 0.005;
+
+                cout << setw(11) << showpos << setprecision(1) << change << noshowpos << "%";
+
+                if( slower || more_allocs ) {
+                    ostringstream msg;
+                    msg << fixed << "REGRESSION: " << op << " at " << limbs << " limbs: "
+                        << setprecision(1) << r.ns << " ns/op (baseline " << it->second.ns << "), "
+                        << setprecision(2) << r.allocs << " allocs/op (baseline "
+                        << it->second.allocs << ")";
+                    regressions.push_back(msg.str());
+                    cout << "  <-- REGRESSION";
+                }
+            }
+            cout << endl;
+
+            if( record.is_open() ) {
+                record << op << " " << limbs << " " << fixed << setprecision(1) << r.ns << " "
+                       << setprecision(2) << r.allocs << endl;
+            }
+        }
+    }
+
+    if( !regressions.empty() ) {
+        for( const string& msg : regressions ) {
+            cerr << msg << endl;
+        }
+        cerr << "Benchmark: " << regressions.size() << " regression(s) against " << baseline_path << endl;
+        return(EXIT_FAILURE);
+    }
+
+    return 0;
+}
\ No newline at end of file
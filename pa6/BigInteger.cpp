@@ -5,33 +5,499 @@
 // pa6
 // Implementation file for BigInteger ADT. The BigInteger ADT will represent
 // a signed integer by encapsulating two pieces of data: an int (which will
-// be either 1, -1, or 0) giving its sign, and a List of non-negative longs
-// representing its magnitude. Each List element will be a single digit in
-// the base 'b' positional numbering system, where 'b' is a power of 10.
-// The reason we chose 'b' to be a power of 10 is to facilitate the conversion
-// between base 10 and base 'b'.
+// be either 1, -1, or 0) giving its sign, and a contiguous vector of limbs
+// representing its magnitude. Each limb will be a single digit in the base
+// 'b' positional numbering system, where 'b' is a power of 10. The reason we
+// chose 'b' to be a power of 10 is to facilitate the conversion between
+// base 10 and base 'b'.
+//
+// Limbs are stored least significant first, so carries run from index 0
+// upward and growth happens at the back of the vector. The magnitude never
+// has leading (high) zero limbs, and zero is represented by an empty vector.
 //-----------------------------------------------------------------------------
 
 #include<iostream>
 #include<string>
 #include<stdexcept>
 #include<cstdlib>
+#include<cctype>
+#include<algorithm>
+#include<utility>
+#include<vector>
+#include<deque>
+#include<functional>
+#include<exception>
+#include<system_error>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<atomic>
+#include<cmath>
+#include<cstring>
 #include"BigInteger.h"
 
+// SSE2/AVX2 limb kernels are built on x86 with GCC or Clang, and picked at
+// run time by CPU support. Define BIGINT_NO_SIMD to use only the portable
+// kernels.
+#if !defined(BIGINT_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define BIGINT_X86_SIMD 1
+#include<immintrin.h>
+#endif
+
 // Global constants -----------------------------------------------------------
 
-const ListElement BASE = 1000000000;                // 1 billion
+const Limb BASE = 1000000000;                       // 1 billion
 const int POWER = 9;
 
+// Operand sizes, in limbs, at which mult() switches from the schoolbook
+// basecase to Karatsuba, and from Karatsuba to Toom-3. Override at build
+// time with -D, or at run time with BigInteger::setMultThresholds().
+#ifndef BIGINT_KARATSUBA_THRESHOLD
+#define BIGINT_KARATSUBA_THRESHOLD 32
+#endif
+#ifndef BIGINT_TOOM3_THRESHOLD
+#define BIGINT_TOOM3_THRESHOLD 200
+#endif
+
+// Operand size, in limbs, at which mult() switches from Toom-3 to the
+// number-theoretic transform. Override with -D or BigInteger::setNTTThreshold().
+#ifndef BIGINT_NTT_THRESHOLD
+#define BIGINT_NTT_THRESHOLD 1500
+#endif
+
+size_t karatsuba_threshold = BIGINT_KARATSUBA_THRESHOLD;
+size_t toom3_threshold = BIGINT_TOOM3_THRESHOLD;
+size_t ntt_threshold = BIGINT_NTT_THRESHOLD;
+
+// Divisor size, in limbs, at which division switches from Knuth's Algorithm D
+// to a Newton-Raphson reciprocal built on the fast multiplier.
+#ifndef BIGINT_NEWTON_THRESHOLD
+#define BIGINT_NEWTON_THRESHOLD 1500
+#endif
+
+size_t newton_threshold = BIGINT_NEWTON_THRESHOLD;
+
+// Threads a single product may use (0 means one per hardware thread), and
+// the shorter-operand size, in limbs, below which a product always runs
+// serially. Override with -D or BigInteger::setMultThreads() and
+// BigInteger::setParallelThreshold().
+#ifndef BIGINT_MULT_THREADS
+#define BIGINT_MULT_THREADS 0
+#endif
+#ifndef BIGINT_PARALLEL_THRESHOLD
+#define BIGINT_PARALLEL_THRESHOLD 10000
+#endif
+
+size_t mult_threads = BIGINT_MULT_THREADS;
+size_t parallel_threshold = BIGINT_PARALLEL_THRESHOLD;
+
+// Threads the product running on this thread may use. Zero on threads the
+// pool did not hand work to, which get the full mult_threads.
+thread_local size_t thread_budget = 0;
+
+// Bytes of free limb buffers the built-in ScratchArenas of all threads keep
+// between them. Override with -D or BigInteger::setScratchLimit().
+#ifndef BIGINT_SCRATCH_LIMIT
+#define BIGINT_SCRATCH_LIMIT (64 << 20)
+#endif
+
+size_t scratch_limit = BIGINT_SCRATCH_LIMIT;
+
+// Bytes of scratch_limit claimed by the built-in arenas. Each claims in
+// grants of SCRATCH_GRANT bytes and hands back what it has not used beyond
+// two grants, so the shared counter is touched once per grant of buffer
+// traffic rather than on every buffer.
+std::atomic<size_t> scratch_claimed(0);
+const size_t SCRATCH_GRANT = 1 << 20;
+
+// The ScratchArena made current on this thread by a Scope, or the built-in
+// one once it has been created; and whether the built-in one has already
+// been destroyed at thread exit. Both are trivially destructible, so they
+// stay readable while other thread-local objects are torn down.
+thread_local ScratchArena* current_arena = nullptr;
+thread_local bool builtin_arena_gone = false;
+
+// NTT primes, all of the form c*2^k + 1 with primitive root 3. The product
+// of the three (about 7.9e25) bounds every convolution coefficient, which is
+// at most NTT_MAX_LENGTH*(BASE-1)^2 (about 8.4e24).
+const Limb NTT_P1 = 998244353;                      // 119*2^23 + 1
+const Limb NTT_P2 = 469762049;                      // 7*2^26 + 1
+const Limb NTT_P3 = 167772161;                      // 5*2^25 + 1
+const size_t NTT_MAX_LENGTH = (size_t)1 << 23;      // largest power of 2 dividing NTT_P1 - 1
+
+// Binary record format written by serialize(); see BigInteger.h.
+const unsigned char RECORD_MAGIC[2] = { 'B', 'I' };
+const unsigned char RECORD_VERSION = 1;
+const size_t RECORD_HEADER = 16;                    // bytes before the limbs
+
 using namespace std;
 
 // Helper functions -----------------------------------------------------------
 
-void negateList(List& L);
-void sumList(List& S, List A, List B, int sgn);
-int normalizeList(List &L);
-void shiftList(List& L, int p);
-void scalarMultList(List& L, ListElement m);
+void normalizeLimbs(LimbVector& L);
+int compareLimbs(const LimbVector& A, const LimbVector& B);
+int compareLimbs(const Limb* A, size_t n, const Limb* B, size_t m);
+std::size_t hashLimbs(int sign, const Limb* L, size_t n);
+void sumLimbs(LimbVector& S, const LimbVector& A, const LimbVector& B);
+void diffLimbs(LimbVector& D, const LimbVector& A, const LimbVector& B);
+void mulLimbs(Limb* P, const Limb* A, size_t n, const Limb* B, size_t m);
+void sqrLimbs(Limb* P, const Limb* A, size_t n);
+void multLimbs(LimbVector& P, const LimbVector& A, const LimbVector& B);
+void mulSmallLimbs(LimbVector& P, const LimbVector& A, Limb k);
+Limb divSmallLimbs(LimbVector& Q, const LimbVector& A, Limb d);
+void divmodLimbs(LimbVector& Q, LimbVector& R, const LimbVector& A, const LimbVector& B);
+
+// ScratchArena ---------------------------------------------------------------
+
+// sizeClass()
+// Returns the class of the smallest buffer size of at least n limbs and
+// sets size to it. Sizes are 5/4, 6/4, 7/4 and 8/4 times a power of 2, so
+// rounding up wastes at most a quarter of a buffer.
+int sizeClass(size_t n, size_t& size) {
+    // small requests share the smallest class, which also keeps n - 1 above
+    // zero for the count of leading zeros
+    if( n<=8 ) {
+        n = 8;
+    }
+
+    // 2^e < n <= 2^(e+1)
+#if defined(__GNUC__) || defined(__clang__)
+    int e = 63 - __builtin_clzll((unsigned long long)(n - 1));
+#else
+    int e = 0;
+    for( size_t m = n - 1; m>1; m >>= 1 ) {
+        e++;
+    }
+#endif
+    size_t quarter = (size_t)1 << (e - 2);
+    size_t steps = (n + quarter - 1)/quarter;                       // 5 to 8
+
+    size = steps*quarter;
+    return 4*e + (int)steps - 5;
+}
+
+// classSize()
+// Returns the buffer size, in limbs, of class cls.
+size_t classSize(int cls) {
+    return ((size_t)(cls % 4) + 5) << (cls/4 - 2);
+}
+
+// ScratchArena()
+// Creates an empty arena that keeps at most limit bytes of free buffers.
+ScratchArena::ScratchArena(size_t limit) : bytes(0), limit(limit), claimed(0), builtin(false) {
+    std::fill(free_list, free_list + CLASSES, nullptr);
+}
+
+// ScratchArena()
+// Creates a thread's built-in arena, limited by setScratchLimit().
+ScratchArena::ScratchArena() : ScratchArena(0) {
+    builtin = true;
+}
+
+// Destructor. Frees every buffer the arena holds and hands back its claim
+// on the shared budget. Once a thread's built-in arena is gone, buffers
+// freed later on that thread go straight back to the heap.
+ScratchArena::~ScratchArena() {
+    clear();
+    scratch_claimed -= claimed;
+
+    if( current_arena==this ) {
+        current_arena = nullptr;
+    }
+    if( builtin ) {
+        builtin_arena_gone = true;
+    }
+}
+
+// cachedBytes()
+// Returns the number of bytes of free buffers the arena holds.
+size_t ScratchArena::cachedBytes() const {
+    return bytes;
+}
+
+// clear()
+// Frees every buffer the arena holds.
+void ScratchArena::clear() {
+    for( int cls = 0; cls < CLASSES; cls++ ) {
+        while( Limb* p = take(cls) ) {
+            delete[] p;
+        }
+    }
+}
+
+// current()
+// Returns the arena LimbVector uses on this thread: the one made current by
+// the innermost Scope, otherwise the thread's built-in arena, created on
+// first use. Returns nullptr once the built-in arena has been destroyed.
+ScratchArena* ScratchArena::current() {
+    if( current_arena==nullptr && !builtin_arena_gone ) {
+        static thread_local ScratchArena builtin_arena;
+        current_arena = &builtin_arena;
+    }
+
+    return current_arena;
+}
+
+// take()
+// Returns a free buffer of class cls, or nullptr if there is none.
+Limb* ScratchArena::take(int cls) {
+    Limb* p = free_list[cls];
+
+    if( p != nullptr ) {
+        std::memcpy(&free_list[cls], p, sizeof(Limb*));
+        bytes -= sizeof(Limb)*classSize(cls);
+
+        // hand back all but one grant of an unused claim
+        if( builtin && claimed - bytes > 2*SCRATCH_GRANT ) {
+            scratch_claimed -= claimed - bytes - SCRATCH_GRANT;
+            claimed = bytes + SCRATCH_GRANT;
+        }
+    }
+
+    return p;
+}
+
+// keep()
+// Adds the buffer p of cls's size to the free lists and returns true, or
+// returns false if that would go over the limit.
+bool ScratchArena::keep(Limb* p, int cls) {
+    size_t size = sizeof(Limb)*classSize(cls);
+
+    if( builtin ) {
+        if( bytes + size > claimed && !claim(bytes + size - claimed) ) {
+            return false;
+        }
+    }
+    else if( bytes + size > limit ) {
+        return false;
+    }
+
+    std::memcpy(p, &free_list[cls], sizeof(Limb*));
+    free_list[cls] = p;
+    bytes += size;
+
+    return true;
+}
+
+// claim()
+// Claims at least need more bytes of the budget the built-in arenas share,
+// a whole grant if there is room for one, and returns false if there is
+// not room for need.
+bool ScratchArena::claim(size_t need) {
+    for( size_t amount : { std::max(need, SCRATCH_GRANT), need } ) {
+        if( scratch_claimed.fetch_add(amount) + amount <= scratch_limit ) {
+            claimed += amount;
+            return true;
+        }
+        scratch_claimed -= amount;
+    }
+
+    return false;
+}
+
+// Scope()
+// Makes arena current on the calling thread.
+ScratchArena::Scope::Scope(ScratchArena& arena) : previous(current_arena) {
+    current_arena = &arena;
+}
+
+// Destructor. Restores the arena that was current before.
+ScratchArena::Scope::~Scope() {
+    current_arena = previous;
+}
+
+
+// LimbVector -----------------------------------------------------------------
+
+// allocate()
+// Returns a heap buffer of at least n limbs from this thread's ScratchArena,
+// or from the heap if it has none free, and sets cap to the buffer's size.
+Limb* LimbVector::allocate(size_t n, std::uint32_t& cap) {
+    size_t size;
+    int cls = sizeClass(n, size);
+    ScratchArena* arena = ScratchArena::current();
+    Limb* p = (arena != nullptr) ? arena->take(cls) : nullptr;
+
+    if( p==nullptr ) {
+        p = new Limb[size];
+    }
+
+    cap = (std::uint32_t)size;
+    return p;
+}
+
+// release()
+// Hands the heap buffer p of cap limbs back to this thread's ScratchArena,
+// which frees it if it is full.
+void LimbVector::release(Limb* p, std::uint32_t cap) {
+    size_t size;
+    int cls = sizeClass(cap, size);
+    ScratchArena* arena = ScratchArena::current();
+
+    if( arena==nullptr || !arena->keep(p, cls) ) {
+        delete[] p;
+    }
+}
+
+// LimbVector()
+// Creates a LimbVector of n limbs, each equal to value.
+LimbVector::LimbVector(size_t n, Limb value) : LimbVector() {
+    assign(n, value);
+}
+
+// LimbVector()
+// Creates a LimbVector holding a copy of the limbs in [first, last).
+LimbVector::LimbVector(const Limb* first, const Limb* last) : LimbVector() {
+    assign(first, last);
+}
+
+// Copy constructor.
+LimbVector::LimbVector(const LimbVector& L) : LimbVector() {
+    assign(L.begin(), L.end());
+}
+
+// Move constructor. Steals the heap buffer of L if it has one, otherwise
+// copies its inline limbs. L is left empty.
+LimbVector::LimbVector(LimbVector&& L) noexcept : LimbVector() {
+    *this = std::move(L);
+}
+
+// reserve()
+// Makes room for at least n limbs without changing the contents. Growth is
+// geometric so repeated push_back() stays amortised O(1).
+void LimbVector::reserve(size_t n) {
+    if( n <= cap ) {
+        return;
+    }
+
+    if( n > MAX_LIMBS ) {
+        throw std::length_error("BigInteger: value too long");
+    }
+
+    std::uint32_t new_cap;
+    Limb* buffer = allocate(std::min(std::max(n, 2*(size_t)cap), (size_t)MAX_LIMBS), new_cap);
+
+    std::copy(ptr, ptr + len, buffer);
+    if( !isInline() ) {
+        release(ptr, cap);
+    }
+
+    ptr = buffer;
+    cap = new_cap;
+}
+
+// resize()
+// Changes the size to n limbs, filling any new limbs with value.
+void LimbVector::resize(size_t n, Limb value) {
+    reserve(n);
+    if( n > len ) {
+        std::fill(ptr + len, ptr + n, value);
+    }
+    len = (std::uint32_t)n;
+}
+
+// assign()
+// Replaces the contents with n copies of value.
+void LimbVector::assign(size_t n, Limb value) {
+    len = 0;
+    resize(n, value);
+}
+
+// assign()
+// Replaces the contents with a copy of the limbs in [first, last), which
+// must not lie inside this LimbVector.
+void LimbVector::assign(const Limb* first, const Limb* last) {
+    len = 0;
+    reserve(last - first);
+    std::copy(first, last, ptr);
+    len = (std::uint32_t)(last - first);
+}
+
+// insert()
+// Inserts n copies of value before pos.
+void LimbVector::insert(Limb* pos, size_t n, Limb value) {
+    size_t at = pos - ptr;
+
+    reserve(len + n);
+    std::copy_backward(ptr + at, ptr + len, ptr + len + n);
+    std::fill(ptr + at, ptr + at + n, value);
+    len += (std::uint32_t)n;
+}
+
+// insert()
+// Inserts a copy of the limbs in [first, last), which must not lie inside
+// this LimbVector, before pos.
+void LimbVector::insert(Limb* pos, const Limb* first, const Limb* last) {
+    size_t at = pos - ptr;
+    size_t n = last - first;
+
+    reserve(len + n);
+    std::copy_backward(ptr + at, ptr + len, ptr + len + n);
+    std::copy(first, last, ptr + at);
+    len += (std::uint32_t)n;
+}
+
+// erase()
+// Removes the limbs in [first, last).
+void LimbVector::erase(Limb* first, Limb* last) {
+    std::copy(last, ptr + len, first);
+    len -= (std::uint32_t)(last - first);
+}
+
+// swap()
+// Exchanges the contents of this LimbVector and L. Two heap buffers trade
+// pointers; inline limbs are copied.
+void LimbVector::swap(LimbVector& L) noexcept {
+    if( this==&L ) {
+        return;
+    }
+
+    LimbVector temp(std::move(L));
+    L = std::move(*this);
+    *this = std::move(temp);
+}
+
+// operator=()
+// Overwrites the contents of this LimbVector with a copy of L's.
+LimbVector& LimbVector::operator=( const LimbVector& L ) {
+    if( this!=&L ) {
+        assign(L.begin(), L.end());
+    }
+
+    return *this;
+}
+
+// operator=()
+// Overwrites the contents of this LimbVector with L's, stealing L's heap
+// buffer when it has one. L is left empty.
+LimbVector& LimbVector::operator=( LimbVector&& L ) noexcept {
+    if( this==&L ) {
+        return *this;
+    }
+
+    if( L.isInline() ) {
+        // small value: copy the limbs, keeping any buffer we already own
+        std::copy(L.ptr, L.ptr + L.len, ptr);
+        len = L.len;
+    }
+    else {
+        if( !isInline() ) {
+            release(ptr, cap);
+        }
+
+        ptr = L.ptr;
+        len = L.len;
+        cap = L.cap;
+
+        L.ptr = L.local;
+        L.cap = INLINE_LIMBS;
+    }
+
+    L.len = 0;
+    return *this;
+}
+
 
 // Class Constructors & Destructors -------------------------------------------
 
@@ -40,544 +506,3580 @@ void scalarMultList(List& L, ListElement m);
 // signum=0, digits=().
 BigInteger::BigInteger() {
     signum = 0;
-    digits = List();
 }
 
-// BigInteger()
-// Constructor that creates a new BigInteger from the long value x.
-BigInteger::BigInteger(long x) {
-    if( x > 0 ) {
-        signum = 1;                             // positive
-    }
-    else if( x < 0 ) {
-        signum = -1;                            // negative
-        x = -x;                                 // make x positive for digit extraction
+// BigInteger()
+// Constructor that creates a new BigInteger from the long value x.
+BigInteger::BigInteger(long x) {
+    unsigned long mag = (unsigned long)x;       // magnitude of x, safe for LONG_MIN
+
+    if( x > 0 ) {
+        signum = 1;                             // positive
+    }
+    else if( x < 0 ) {
+        signum = -1;                            // negative
+        mag = 0UL - mag;                        // make mag positive for digit extraction
+    }
+    else {
+        signum = 0;                             // zero
+    }
+
+    // get digits from x and append them, least significant first
+    while( mag > 0 ) {
+        digits.push_back((Limb)(mag % BASE));   // extract the last digit of x in base BASE
+        mag /= BASE;                            // move to next digit
+    }
+}
+
+// BigInteger()
+// Constructor that creates a new BigInteger from the string s.
+// Pre: s is a non-empty string consisting of (at least one) base 10 digit
+// {0,1,2,3,4,5,6,7,8,9}, and an optional sign {+,-} prefix.
+BigInteger::BigInteger(const std::string& s) {
+    // error message
+    if( s.length()==0 ) {
+        throw std::invalid_argument("BigInteger: Constructor: empty string");
+    }
+
+    // determine the sign of the BigInteger
+    size_t start = 0;
+    signum = 1;                                 // default to positive sign
+
+    if( s[0]=='+' || s[0]=='-' ) {
+        if( s[0]=='-' ) {
+            signum = -1;                        // set to negative if '-' is at s[0]
+        }
+        start = 1;                              // skip the sign prefix
+    }
+
+    // error message if only a sign was given
+    if( start==s.length() ) {
+        throw std::invalid_argument("BigInteger: Constructor: non-numeric string");
+    }
+
+    // convert the string in groups of POWER digits, starting from the least
+    // significant end, straight into a preallocated limb buffer. Each digit
+    // is validated in the same pass.
+    size_t num_digits = s.length() - start;
+    digits.resize((num_digits + POWER - 1)/POWER);
+
+    size_t end = s.length();
+    for( size_t k = 0; k < digits.size(); k++ ) {
+        size_t begin = (end - start > (size_t)POWER) ? end - POWER : start;
+        Limb value = 0;
+
+        for( size_t i = begin; i < end; i++ ) {
+            Limb c = (Limb)((unsigned char)s[i] - '0');
+
+            // error message if not numeric
+            if( c > 9 ) {
+                throw std::invalid_argument("BigInteger: Constructor: non-numeric string");
+            }
+
+            value = value*10 + c;
+        }
+
+        digits[k] = value;
+        end = begin;
+    }
+
+    normalizeLimbs(digits);
+
+    if( digits.empty() ) {
+        signum = 0;                             // "-0" and "000" are both zero
+    }
+}
+
+// BigInteger()
+// Constructor that creates a copy of N.
+BigInteger::BigInteger(const BigInteger& N) {
+    digits = N.digits;
+    signum = N.signum;
+}
+
+// BigInteger()
+// Constructor that takes over the limbs of N without copying them. N is
+// left in the zero state.
+BigInteger::BigInteger(BigInteger&& N) noexcept : signum(N.signum), digits(std::move(N.digits)) {
+    N.signum = 0;
+    N.digits.clear();
+}
+
+
+// Access functions -----------------------------------------------------------
+
+// sign()
+// Returns -1, 1 or 0 according to whether this BigInteger is positive,
+// negative or 0, respectively.
+int BigInteger::sign() const {
+    return signum;
+}
+
+// compare()
+// Returns -1, 1 or 0 according to whether this BigInteger is less than N,
+// greater than N or equal to N, respectively.
+int BigInteger::compare(const BigInteger& N) const {
+    // compare signs
+    if( signum!=N.signum ) {
+        return (signum < N.signum) ? -1 : 1;
+    }
+
+    // same sign: compare magnitudes, reversing the result for negatives
+    int cmp = compareLimbs(digits, N.digits);
+
+    return (signum==-1) ? -cmp : cmp;
+}
+
+// hash()
+// Returns a hash of this BigInteger's value, read from the limbs in place.
+std::size_t BigInteger::hash() const {
+    return hashLimbs(signum, digits.data(), digits.size());
+}
+
+
+// Manipulation procedures -------------------------------------------------
+
+// makeZero()
+// Re-sets this BigInteger to the zero state.
+void BigInteger::makeZero() {
+    signum = 0;
+    digits.clear();
+}
+
+// negate()
+// If this BigInteger is zero, does nothing, otherwise reverses the sign of
+// this BigInteger positive <--> negative.
+void BigInteger::negate() {
+    if( signum!=0 ) {
+        signum *= -1;
+    }
+}
+
+
+// addInPlace()
+// Overwrites this BigInteger with this + sgn*N, reusing its limb storage.
+// Used by operator+=() and operator-=().
+void BigInteger::addInPlace(const BigInteger& N, int sgn) {
+    int nsign = sgn*N.signum;
+
+    if( nsign==0 ) {
+        return;
+    }
+    else if( signum==0 ) {
+        digits = N.digits;
+        signum = nsign;
+    }
+    else if( signum==nsign ) {
+        sumLimbs(digits, digits, N.digits);     // same sign: add magnitudes
+    }
+    else {
+        // opposite signs: subtract the smaller magnitude from the larger
+        int cmp = compareLimbs(digits, N.digits);
+
+        if( cmp > 0 ) {
+            diffLimbs(digits, digits, N.digits);
+        }
+        else if( cmp < 0 ) {
+            diffLimbs(digits, N.digits, digits);
+            signum = nsign;
+        }
+        else {
+            makeZero();
+        }
+    }
+}
+
+
+// Thread pool ----------------------------------------------------------------
+
+// ThreadPool
+// The worker threads parallelFor() hands chunks of a product to. Workers
+// start on first use, grow on demand and are joined at exit. A thread that
+// waits on its own chunks runs queued tasks meanwhile, so nested
+// parallelFor() calls (a parallel Toom-3 whose pieces run a parallel NTT)
+// cannot deadlock, and work still finishes if no worker could be started.
+class ThreadPool {
+public:
+    // instance()
+    // Returns the process-wide pool.
+    static ThreadPool& instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // reserve()
+    // Starts workers until there are at least n, as far as the system allows.
+    void reserve(size_t n) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        try {
+            while( workers.size() < n ) {
+                workers.emplace_back([this] { work(); });
+            }
+        }
+        catch( const std::system_error& ) {
+            // carry on with the workers we have
+        }
+    }
+
+    // submit()
+    // Queues task for the next free thread.
+    void submit(std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        changed.notify_all();
+    }
+
+    // finish()
+    // Marks one of the chunks counted by pending as done.
+    void finish(size_t& pending) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending--;
+        changed.notify_all();
+    }
+
+    // waitFor()
+    // Returns once pending reaches zero, running queued tasks until then.
+    void waitFor(const size_t& pending) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while( pending != 0 ) {
+            if( !tasks.empty() ) {
+                std::function<void()> task = std::move(tasks.front());
+                tasks.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+            else {
+                changed.wait(lock);
+            }
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            changed.notify_all();
+        }
+        for( std::thread& t : workers ) {
+            t.join();
+        }
+    }
+
+private:
+    ThreadPool() = default;
+
+    // work()
+    // Worker loop: run tasks until the pool is destroyed.
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for( ;; ) {
+            changed.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if( tasks.empty() ) {
+                return;
+            }
+
+            std::function<void()> task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+};
+
+// threadBudget()
+// Returns the number of threads the product running on this thread may use.
+size_t threadBudget() {
+    if( thread_budget != 0 ) {
+        return thread_budget;
+    }
+    if( mult_threads != 0 ) {
+        return mult_threads;
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// multThreads()
+// Returns the number of threads to spread a product over when its shorter
+// operand has m limbs: one below parallel_threshold, else the budget.
+size_t multThreads(size_t m) {
+    return (m >= parallel_threshold) ? threadBudget() : 1;
+}
+
+// parallelFor()
+// Splits [0, count) into at most threads contiguous chunks and calls
+// f(begin, end) on each, one chunk on the calling thread and the rest on
+// the pool, returning when all are done. Each chunk gets an even share of
+// this thread's budget for any parallelism of its own. The first exception
+// thrown by a chunk is rethrown here. With one thread this is just
+// f(0, count).
+template<class F>
+void parallelFor(size_t count, size_t threads, const F& f) {
+    threads = std::min(threads, count);
+
+    if( threads <= 1 ) {
+        f(0, count);
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    size_t share = std::max(threadBudget()/threads, (size_t)1);
+    size_t pending = threads - 1;               // guarded by the pool's mutex
+    vector<std::exception_ptr> errors(threads);
+
+    auto chunk = [&](size_t t) {
+        size_t saved = thread_budget;
+        thread_budget = share;
+        try {
+            f(count*t/threads, count*(t + 1)/threads);
+        }
+        catch( ... ) {
+            errors[t] = std::current_exception();
+        }
+        thread_budget = saved;
+    };
+
+    pool.reserve(threads - 1);
+
+    size_t t = 1;
+    try {
+        for( ; t < threads; t++ ) {
+            pool.submit([&chunk, &pool, &pending, t] { chunk(t); pool.finish(pending); });
+        }
+    }
+    catch( ... ) {
+        // could not queue the rest: run them here
+        for( ; t < threads; t++ ) {
+            chunk(t);
+            pool.finish(pending);
+        }
+    }
+
+    chunk(0);
+    pool.waitFor(pending);
+
+    for( const std::exception_ptr& e : errors ) {
+        if( e ) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+
+// Limb kernels ---------------------------------------------------------------
+
+// The innermost loops of add, sub and scalar multiply, over n limbs of
+// equal length with the carry (or borrow) fused into the same pass. Each
+// comes in a portable version and, on x86, SSE2 and AVX2 versions that
+// work on 4 or 8 limbs per step; limbKernels() picks the best one the CPU
+// supports. The vector versions resolve carries across lanes with mask
+// arithmetic: a lane generates a carry if its sum is >= BASE and
+// propagates one if its sum is exactly BASE-1, so with G and P as lane
+// bitmasks the lanes that receive a carry are ((G << 1 | carry) + P) ^ P,
+// exactly as in a binary adder.
+
+// addKernel()
+// Writes the n limbs of A + B + carry to S and returns the carry out. S may
+// alias A or B. Pre: carry <= 1.
+Limb addKernel(Limb* S, const Limb* A, const Limb* B, size_t n, Limb carry) {
+    for( size_t i = 0; i < n; i++ ) {
+        Limb sum = A[i] + B[i] + carry;         // < 2*BASE, fits in a Limb
+        carry = (sum >= BASE);
+        S[i] = carry ? sum - BASE : sum;
+    }
+    return carry;
+}
+
+// subKernel()
+// Writes the n limbs of A - B - borrow to D and returns the borrow out. D
+// may alias A or B. Pre: borrow <= 1.
+Limb subKernel(Limb* D, const Limb* A, const Limb* B, size_t n, Limb borrow) {
+    for( size_t i = 0; i < n; i++ ) {
+        Limb sub = B[i] + borrow;
+        Limb a = A[i];
+        borrow = (a < sub);
+        D[i] = borrow ? a + BASE - sub : a - sub;
+    }
+    return borrow;
+}
+
+// mulKernel()
+// Writes the n low limbs of A*k + carry to P and returns the limb carried
+// out. P may alias A. Each product is split into its low and high limbs on
+// its own, so the only dependency between steps is a one-bit carry.
+// Pre: k < BASE, carry < BASE.
+Limb mulKernel(Limb* P, const Limb* A, size_t n, Limb k, Limb carry) {
+    Limb high = carry;
+    Limb c = 0;
+
+    for( size_t i = 0; i < n; i++ ) {
+        DLimb t = (DLimb)A[i]*k;
+        Limb hi = (Limb)(t / BASE);
+        Limb sum = (Limb)(t - (DLimb)hi*BASE) + high + c;   // < 2*BASE
+        c = (sum >= BASE);
+        P[i] = c ? sum - BASE : sum;
+        high = hi;
+    }
+
+    return high + c;                            // < BASE, as hi <= BASE-2
+}
+
+#ifdef BIGINT_X86_SIMD
+
+// addKernelSSE2()
+// addKernel() on 4 limbs per step.
+__attribute__((target("sse2")))
+Limb addKernelSSE2(Limb* S, const Limb* A, const Limb* B, size_t n, Limb carry) {
+    const __m128i top = _mm_set1_epi32(BASE - 1);
+    const __m128i base = _mm_set1_epi32(BASE);
+    const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+    size_t i = 0;
+
+    for( ; i + 4 <= n; i += 4 ) {
+        __m128i s = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(A + i)),
+                                  _mm_loadu_si128((const __m128i*)(B + i)));
+        unsigned g = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(s, top)));
+        unsigned p = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(s, top)));
+        unsigned t = ((g << 1) | carry) + p;
+        __m128i in = _mm_set1_epi32((int)((t ^ p) & 0xF));
+
+        carry = (t >> 4) & 1;
+        s = _mm_sub_epi32(s, _mm_cmpeq_epi32(_mm_and_si128(in, lanes), lanes));
+        s = _mm_sub_epi32(s, _mm_and_si128(_mm_cmpgt_epi32(s, top), base));
+        _mm_storeu_si128((__m128i*)(S + i), s);
+    }
+
+    return addKernel(S + i, A + i, B + i, n - i, carry);
+}
+
+// subKernelSSE2()
+// subKernel() on 4 limbs per step.
+__attribute__((target("sse2")))
+Limb subKernelSSE2(Limb* D, const Limb* A, const Limb* B, size_t n, Limb borrow) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i base = _mm_set1_epi32(BASE);
+    const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+    size_t i = 0;
+
+    for( ; i + 4 <= n; i += 4 ) {
+        __m128i d = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(A + i)),
+                                  _mm_loadu_si128((const __m128i*)(B + i)));
+        unsigned g = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(zero, d)));
+        unsigned p = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(d, zero)));
+        unsigned t = ((g << 1) | borrow) + p;
+        __m128i in = _mm_set1_epi32((int)((t ^ p) & 0xF));
+
+        borrow = (t >> 4) & 1;
+        d = _mm_add_epi32(d, _mm_cmpeq_epi32(_mm_and_si128(in, lanes), lanes));
+        d = _mm_add_epi32(d, _mm_and_si128(_mm_cmpgt_epi32(zero, d), base));
+        _mm_storeu_si128((__m128i*)(D + i), d);
+    }
+
+    return subKernel(D + i, A + i, B + i, n - i, borrow);
+}
+
+// addKernelAVX2()
+// addKernel() on 8 limbs per step.
+__attribute__((target("avx2")))
+Limb addKernelAVX2(Limb* S, const Limb* A, const Limb* B, size_t n, Limb carry) {
+    const __m256i top = _mm256_set1_epi32(BASE - 1);
+    const __m256i base = _mm256_set1_epi32(BASE);
+    const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    size_t i = 0;
+
+    for( ; i + 8 <= n; i += 8 ) {
+        __m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(A + i)),
+                                     _mm256_loadu_si256((const __m256i*)(B + i)));
+        unsigned g = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(s, top)));
+        unsigned p = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(s, top)));
+        unsigned t = ((g << 1) | carry) + p;
+        __m256i in = _mm256_set1_epi32((int)((t ^ p) & 0xFF));
+
+        carry = (t >> 8) & 1;
+        s = _mm256_sub_epi32(s, _mm256_cmpeq_epi32(_mm256_and_si256(in, lanes), lanes));
+        s = _mm256_sub_epi32(s, _mm256_and_si256(_mm256_cmpgt_epi32(s, top), base));
+        _mm256_storeu_si256((__m256i*)(S + i), s);
+    }
+
+    return addKernel(S + i, A + i, B + i, n - i, carry);
+}
+
+// subKernelAVX2()
+// subKernel() on 8 limbs per step.
+__attribute__((target("avx2")))
+Limb subKernelAVX2(Limb* D, const Limb* A, const Limb* B, size_t n, Limb borrow) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i base = _mm256_set1_epi32(BASE);
+    const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    size_t i = 0;
+
+    for( ; i + 8 <= n; i += 8 ) {
+        __m256i d = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(A + i)),
+                                     _mm256_loadu_si256((const __m256i*)(B + i)));
+        unsigned g = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(zero, d)));
+        unsigned p = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(d, zero)));
+        unsigned t = ((g << 1) | borrow) + p;
+        __m256i in = _mm256_set1_epi32((int)((t ^ p) & 0xFF));
+
+        borrow = (t >> 8) & 1;
+        d = _mm256_add_epi32(d, _mm256_cmpeq_epi32(_mm256_and_si256(in, lanes), lanes));
+        d = _mm256_add_epi32(d, _mm256_and_si256(_mm256_cmpgt_epi32(zero, d), base));
+        _mm256_storeu_si256((__m256i*)(D + i), d);
+    }
+
+    return subKernel(D + i, A + i, B + i, n - i, borrow);
+}
+
+// mulKernelAVX2()
+// mulKernel() on 4 limbs per step. The high limb of each product is
+// estimated in double precision, made exact with one correction step in
+// 64-bit integers, and the low limbs plus the shifted high limbs are then
+// added with the same mask carry resolution as addKernelAVX2().
+__attribute__((target("avx2")))
+Limb mulKernelAVX2(Limb* P, const Limb* A, size_t n, Limb k, Limb carry) {
+    const __m256d scale = _mm256_set1_pd((double)k/BASE);
+    const __m256i k64 = _mm256_set1_epi64x(k);
+    const __m256i base64 = _mm256_set1_epi64x(BASE);
+    const __m256i top64 = _mm256_set1_epi64x(BASE - 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const __m128i top = _mm_set1_epi32(BASE - 1);
+    const __m128i base = _mm_set1_epi32(BASE);
+    const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+    Limb high = carry;
+    Limb c = 0;
+    size_t i = 0;
+
+    for( ; i + 4 <= n; i += 4 ) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(A + i));
+
+        // q = floor(a*k/BASE), then lo = a*k - q*BASE, corrected into [0, BASE)
+        __m256i q = _mm256_cvtepu32_epi64(_mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(a), scale)));
+        __m256i lo = _mm256_sub_epi64(_mm256_mul_epu32(_mm256_cvtepu32_epi64(a), k64),
+                                      _mm256_mul_epu32(q, base64));
+        __m256i under = _mm256_cmpgt_epi64(zero, lo);
+        __m256i over = _mm256_cmpgt_epi64(lo, top64);
+
+        lo = _mm256_sub_epi64(_mm256_add_epi64(lo, _mm256_and_si256(under, base64)),
+                              _mm256_and_si256(over, base64));
+        q = _mm256_sub_epi64(_mm256_add_epi64(q, under), over);
+
+        // back to 32-bit lanes; limb j gets lo[j] + q[j-1], with q[-1] = high
+        __m128i lo32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(lo, even));
+        __m128i q32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(q, even));
+        __m128i s = _mm_add_epi32(lo32, _mm_or_si128(_mm_slli_si128(q32, 4), _mm_cvtsi32_si128((int)high)));
+
+        high = (Limb)_mm_extract_epi32(q32, 3);
+
+        unsigned g = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(s, top)));
+        unsigned p = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(s, top)));
+        unsigned t = ((g << 1) | c) + p;
+        __m128i in = _mm_set1_epi32((int)((t ^ p) & 0xF));
+
+        c = (t >> 4) & 1;
+        s = _mm_sub_epi32(s, _mm_cmpeq_epi32(_mm_and_si128(in, lanes), lanes));
+        s = _mm_sub_epi32(s, _mm_and_si128(_mm_cmpgt_epi32(s, top), base));
+        _mm_storeu_si128((__m128i*)(P + i), s);
+    }
+
+    return mulKernel(P + i, A + i, n - i, k, high + c);
+}
+
+#endif
+
+// LimbKernels
+// The kernel versions in use.
+struct LimbKernels {
+    Limb (*add)(Limb*, const Limb*, const Limb*, size_t, Limb);
+    Limb (*sub)(Limb*, const Limb*, const Limb*, size_t, Limb);
+    Limb (*mul)(Limb*, const Limb*, size_t, Limb, Limb);
+};
+
+// limbKernels()
+// Returns the fastest kernels this CPU supports, chosen on first call.
+const LimbKernels& limbKernels() {
+    static const LimbKernels kernels = [] {
+        LimbKernels K = { addKernel, subKernel, mulKernel };
+#ifdef BIGINT_X86_SIMD
+        __builtin_cpu_init();
+        if( __builtin_cpu_supports("avx2") ) {
+            K = { addKernelAVX2, subKernelAVX2, mulKernelAVX2 };
+        }
+        else if( __builtin_cpu_supports("sse2") ) {
+            K = { addKernelSSE2, subKernelSSE2, mulKernel };
+        }
+#endif
+        return K;
+    }();
+    return kernels;
+}
+
+
+// Helper functions implementation -----------------------------------------
+
+// normalizeLimbs()
+// Removes leading (most significant) zero limbs from L. Used by every
+// operation that may shrink a magnitude.
+void normalizeLimbs(LimbVector& L) {
+    while( !L.empty() && L.back()==0 ) {
+        L.pop_back();
+    }
+}
+
+// compareLimbs()
+// Returns -1, 1 or 0 according to whether the magnitude A is less than,
+// greater than or equal to the magnitude B. Used by compare(), add() and
+// sub().
+int compareLimbs(const LimbVector& A, const LimbVector& B) {
+    return compareLimbs(A.data(), A.size(), B.data(), B.size());
+}
+
+// compareLimbs()
+// Returns -1, 0 or 1 as the n-limb magnitude at A is less than, equal to
+// or greater than the m-limb magnitude at B. Used by BigIntegerView.
+int compareLimbs(const Limb* A, size_t n, const Limb* B, size_t m) {
+    if( n!=m ) {
+        return (n < m) ? -1 : 1;
+    }
+
+    // walk from the most significant limb down, exit on the first difference
+    for( size_t i = n; i-- > 0; ) {
+        if( A[i]!=B[i] ) {
+            return (A[i] < B[i]) ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+// hashLimbs()
+// Returns a hash of the value with the given sign and the n limbs at L.
+// Limbs are taken two at a time as 64-bit words and folded in with the
+// splitmix64 finaliser. Used by hash() and BigIntegerView::hash().
+std::size_t hashLimbs(int sign, const Limb* L, size_t n) {
+    auto mix = [](std::uint64_t x) {
+        x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    };
+
+    std::uint64_t h = 0x9e3779b97f4a7c15ULL*(std::uint64_t)(sign + 2);
+    size_t i = 0;
+
+    for( ; i + 1 < n; i += 2 ) {
+        h = mix(h ^ (L[i] | (std::uint64_t)L[i + 1] << 32));
+    }
+    if( i < n ) {
+        h = mix(h ^ L[i]);
+    }
+
+    return (std::size_t)mix(h ^ n);
+}
+
+// sumLimbs()
+// Overwrites S with the magnitude A + B. S may alias A or B. Used by add()
+// and sub().
+void sumLimbs(LimbVector& S, const LimbVector& A, const LimbVector& B) {
+    const LimbVector& L = (A.size() >= B.size()) ? A : B;     // longer operand
+    const LimbVector& R = (A.size() >= B.size()) ? B : A;     // shorter operand
+    size_t n = L.size();
+    size_t m = R.size();
+
+    S.resize(n);
+
+    // carry is fused into the same pass as the limb-wise sum
+    Limb carry = limbKernels().add(S.data(), L.data(), R.data(), m, 0);
+    size_t i = m;
+
+    for( ; i < n; i++ ) {
+        Limb sum = L[i] + carry;
+        carry = (sum >= BASE);
+        S[i] = carry ? sum - BASE : sum;
+    }
+
+    if( carry ) {
+        S.push_back(carry);                     // remaining carry becomes a new limb
+    }
+}
+
+// diffLimbs()
+// Overwrites D with the magnitude A - B. D may alias A or B.
+// Pre: A >= B as magnitudes. Used by add() and sub().
+void diffLimbs(LimbVector& D, const LimbVector& A, const LimbVector& B) {
+    size_t n = A.size();
+    size_t m = B.size();
+
+    D.resize(n);
+
+    // borrow is fused into the same pass as the limb-wise difference
+    Limb borrow = limbKernels().sub(D.data(), A.data(), B.data(), m, 0);
+    size_t i = m;
+
+    for( ; i < n; i++ ) {
+        Limb a = A[i];
+        D[i] = (a < borrow) ? a + BASE - borrow : a - borrow;
+        borrow = (a < borrow);
+    }
+
+    normalizeLimbs(D);
+}
+
+// addInto()
+// Adds the a_len limbs at A into the r_len limbs at R, propagating the carry
+// as far as needed. Pre: the true sum fits in r_len limbs. Used by the
+// multiplication tiers.
+void addInto(Limb* R, size_t r_len, const Limb* A, size_t a_len) {
+    Limb carry = limbKernels().add(R, R, A, a_len, 0);
+    size_t i = a_len;
+
+    for( ; carry && i < r_len; i++ ) {
+        Limb sum = R[i] + 1;
+        carry = (sum >= BASE);
+        R[i] = carry ? 0 : sum;
+    }
+}
+
+// subFrom()
+// Subtracts the a_len limbs at A from the r_len limbs at R, propagating the
+// borrow as far as needed. Pre: R >= A. Used by the multiplication tiers.
+void subFrom(Limb* R, size_t r_len, const Limb* A, size_t a_len) {
+    Limb borrow = limbKernels().sub(R, R, A, a_len, 0);
+    size_t i = a_len;
+
+    for( ; borrow && i < r_len; i++ ) {
+        borrow = (R[i]==0);
+        R[i] = borrow ? BASE - 1 : R[i] - 1;
+    }
+}
+
+// trimmedLength()
+// Returns len minus the number of leading (high) zero limbs at A.
+size_t trimmedLength(const Limb* A, size_t len) {
+    while( len > 0 && A[len - 1]==0 ) {
+        len--;
+    }
+    return len;
+}
+
+// mulBasecase()
+// Writes the n+m limb product A*B to P using schoolbook multiplication, one
+// carry propagation per row. P must not alias A or B.
+void mulBasecase(Limb* P, const Limb* A, size_t n, const Limb* B, size_t m) {
+    std::fill(P, P + n + m, 0);
+
+    for( size_t i = 0; i < n; i++ ) {
+        DLimb a = A[i];
+        DLimb carry = 0;
+
+        if( a==0 ) {
+            continue;
+        }
+
+        for( size_t j = 0; j < m; j++ ) {
+            DLimb t = P[i + j] + a*B[j] + carry;    // < BASE^2 + 2*BASE, no overflow
+            P[i + j] = (Limb)(t % BASE);
+            carry = t / BASE;
+        }
+
+        P[i + m] = (Limb)carry;
+    }
+}
+
+// sqrBasecase()
+// Writes the 2n limb square of A to P. Each cross product A[i]*A[j], i < j,
+// is formed once; the triangle is then doubled and the diagonal squares
+// A[i]^2 added in a single carry pass. P must not alias A.
+void sqrBasecase(Limb* P, const Limb* A, size_t n) {
+    std::fill(P, P + 2*n, 0);
+
+    for( size_t i = 0; i + 1 < n; i++ ) {
+        DLimb a = A[i];
+        DLimb carry = 0;
+
+        if( a==0 ) {
+            continue;
+        }
+
+        for( size_t j = i + 1; j < n; j++ ) {
+            DLimb t = P[i + j] + a*A[j] + carry;
+            P[i + j] = (Limb)(t % BASE);
+            carry = t / BASE;
+        }
+
+        P[i + n] = (Limb)carry;
+    }
+
+    // P = 2*P + sum of A[i]^2 * BASE^2i
+    DLimb carry = 0;
+
+    for( size_t k = 0; k < 2*n; k++ ) {
+        DLimb t = 2*(DLimb)P[k] + carry;        // < 2*BASE + BASE^2/BASE, no overflow
+        if( (k & 1)==0 ) {
+            t += (DLimb)A[k/2]*A[k/2];
+        }
+        P[k] = (Limb)(t % BASE);
+        carry = t / BASE;
+    }
+}
+
+// mulKaratsuba()
+// Writes the n+m limb product A*B to P by splitting both operands at
+// h = ceil(n/2) and computing three half-size products:
+//   A*B = z2*BASE^2h + (z1 - z2 - z0)*BASE^h + z0,
+// with z0 = A0*B0, z2 = A1*B1 and z1 = (A0+A1)*(B0+B1). The three products
+// are independent and run in parallel for large operands.
+// Pre: n >= m > ceil(n/2).
+void mulKaratsuba(Limb* P, const Limb* A, size_t n, const Limb* B, size_t m) {
+    size_t h = (n + 1)/2;
+
+    // (A0+A1) and (B0+B1) each fit in h+1 limbs
+    LimbVector sa(A, A + h);
+    LimbVector sb(B, B + h);
+    sa.push_back(0);
+    sb.push_back(0);
+    addInto(sa.data(), h + 1, A + h, n - h);
+    addInto(sb.data(), h + 1, B + h, m - h);
+
+    size_t sa_len = trimmedLength(sa.data(), h + 1);
+    size_t sb_len = trimmedLength(sb.data(), h + 1);
+
+    // z0 and z2 are written straight into their final place in P
+    LimbVector z1(2*h + 2, 0);
+
+    parallelFor(3, multThreads(m), [&](size_t begin, size_t end) {
+        for( size_t i = begin; i < end; i++ ) {
+            if( i==0 ) {
+                mulLimbs(P, A, h, B, h);
+            }
+            else if( i==1 ) {
+                mulLimbs(P + 2*h, A + h, n - h, B + h, m - h);
+            }
+            else if( sa_len > 0 && sb_len > 0 ) {
+                mulLimbs(z1.data(), sa.data(), sa_len, sb.data(), sb_len);
+            }
+        }
+    });
+
+    // z1 = (A0+A1)*(B0+B1) - z0 - z2
+    subFrom(z1.data(), z1.size(), P, 2*h);
+    subFrom(z1.data(), z1.size(), P + 2*h, n + m - 2*h);
+
+    addInto(P + h, n + m - h, z1.data(), trimmedLength(z1.data(), z1.size()));
+}
+
+// sqrKaratsuba()
+// Writes the 2n limb square of A to P with the Karatsuba identity
+//   A^2 = z2*BASE^2h + (z1 - z2 - z0)*BASE^h + z0,
+// where z0 = A0^2, z2 = A1^2 and z1 = (A0+A1)^2 are all squarings.
+void sqrKaratsuba(Limb* P, const Limb* A, size_t n) {
+    size_t h = (n + 1)/2;
+
+    LimbVector sa(A, A + h);
+    sa.push_back(0);
+    addInto(sa.data(), h + 1, A + h, n - h);
+
+    size_t sa_len = trimmedLength(sa.data(), h + 1);
+    LimbVector z1(2*h + 2, 0);
+
+    parallelFor(3, multThreads(n), [&](size_t begin, size_t end) {
+        for( size_t i = begin; i < end; i++ ) {
+            if( i==0 ) {
+                sqrLimbs(P, A, h);
+            }
+            else if( i==1 ) {
+                sqrLimbs(P + 2*h, A + h, n - h);
+            }
+            else if( sa_len > 0 ) {
+                sqrLimbs(z1.data(), sa.data(), sa_len);
+            }
+        }
+    });
+
+    // z1 = (A0+A1)^2 - z0 - z2
+    subFrom(z1.data(), z1.size(), P, 2*h);
+    subFrom(z1.data(), z1.size(), P + 2*h, 2*n - 2*h);
+
+    addInto(P + h, 2*n - h, z1.data(), trimmedLength(z1.data(), z1.size()));
+}
+
+// SignedLimbs
+// A signed magnitude used for the negative evaluation points of Toom-3.
+struct SignedLimbs {
+    int sign;
+    LimbVector mag;
+};
+
+// signedSum()
+// Overwrites R with X + sgn*Y. R may alias X or Y. Used by mulToom3().
+void signedSum(SignedLimbs& R, const SignedLimbs& X, const SignedLimbs& Y, int sgn) {
+    int ysign = sgn*Y.sign;
+
+    if( Y.sign==0 ) {
+        R = X;
+    }
+    else if( X.sign==0 ) {
+        R.mag = Y.mag;
+        R.sign = ysign;
+    }
+    else if( X.sign==ysign ) {
+        R.sign = X.sign;
+        sumLimbs(R.mag, X.mag, Y.mag);
+    }
+    else {
+        int cmp = compareLimbs(X.mag, Y.mag);
+        int xsign = X.sign;
+
+        if( cmp > 0 ) {
+            diffLimbs(R.mag, X.mag, Y.mag);
+            R.sign = xsign;
+        }
+        else if( cmp < 0 ) {
+            diffLimbs(R.mag, Y.mag, X.mag);
+            R.sign = ysign;
+        }
+        else {
+            R.mag.clear();
+            R.sign = 0;
+        }
+    }
+}
+
+// signedScale()
+// Multiplies X by the small factor k in place. Used by mulToom3().
+void signedScale(SignedLimbs& X, Limb k) {
+    mulSmallLimbs(X.mag, X.mag, k);
+}
+
+// signedDivExact()
+// Divides X by the small divisor d in place. Pre: d divides X. Used by
+// mulToom3() for the exact divisions of the interpolation step.
+void signedDivExact(SignedLimbs& X, Limb d) {
+    DLimb rem = 0;
+
+    for( size_t i = X.mag.size(); i-- > 0; ) {
+        DLimb cur = rem*BASE + X.mag[i];
+        X.mag[i] = (Limb)(cur / d);
+        rem = cur % d;
+    }
+
+    normalizeLimbs(X.mag);
+    if( X.mag.empty() ) {
+        X.sign = 0;
+    }
+}
+
+// signedMult()
+// Overwrites R with X*Y. R must not alias X or Y. Used by mulToom3().
+void signedMult(SignedLimbs& R, const SignedLimbs& X, const SignedLimbs& Y) {
+    R.sign = X.sign*Y.sign;
+
+    if( R.sign==0 ) {
+        R.mag.clear();
+        return;
+    }
+
+    multLimbs(R.mag, X.mag, Y.mag);
+}
+
+// signedSquare()
+// Overwrites R with X^2. R must not alias X. Used by sqrToom3().
+void signedSquare(SignedLimbs& R, const SignedLimbs& X) {
+    R.sign = X.sign*X.sign;
+
+    if( R.sign==0 ) {
+        R.mag.clear();
+        return;
+    }
+
+    R.mag.resize(2*X.mag.size());
+    sqrLimbs(R.mag.data(), X.mag.data(), X.mag.size());
+    normalizeLimbs(R.mag);
+}
+
+// toomPiece()
+// Returns the len limbs at A as a trimmed SignedLimbs. Used by mulToom3().
+SignedLimbs toomPiece(const Limb* A, size_t len) {
+    len = trimmedLength(A, len);
+    return SignedLimbs{ (len > 0) ? 1 : 0, LimbVector(A, A + len) };
+}
+
+// toomInterpolate()
+// Recovers the five coefficients of a Toom-3 product from its values r0,
+// r1, rm1, rm2 and rinf at 0, 1, -1, -2 and infinity with Bodrato's
+// sequence, and writes the len limb result to P. Clobbers r1. Used by
+// mulToom3() and sqrToom3().
+void toomInterpolate(Limb* P, size_t len, size_t k, const SignedLimbs& r0, SignedLimbs& r1,
+                     const SignedLimbs& rm1, const SignedLimbs& rm2, const SignedLimbs& rinf) {
+    SignedLimbs r2, r3;
+
+    signedSum(r3, rm2, r1, -1);                 // r3 = (rm2 - r1)/3
+    signedDivExact(r3, 3);
+    signedSum(r1, r1, rm1, -1);                 // r1 = (r1 - rm1)/2
+    signedDivExact(r1, 2);
+    signedSum(r2, rm1, r0, -1);                 // r2 = rm1 - r0
+    signedSum(r3, r2, r3, -1);                  // r3 = (r2 - r3)/2 + 2*rinf
+    signedDivExact(r3, 2);
+    signedSum(r3, r3, rinf, 1);
+    signedSum(r3, r3, rinf, 1);
+    signedSum(r2, r2, r1, 1);                   // r2 = r2 + r1 - rinf
+    signedSum(r2, r2, rinf, -1);
+    signedSum(r1, r1, r3, -1);                  // r1 = r1 - r3
+
+    // recompose: every coefficient is non-negative at this point
+    std::fill(P, P + len, 0);
+    std::copy(r0.mag.begin(), r0.mag.end(), P);
+    addInto(P + k, len - k, r1.mag.data(), r1.mag.size());
+    addInto(P + 2*k, len - 2*k, r2.mag.data(), r2.mag.size());
+    addInto(P + 3*k, len - 3*k, r3.mag.data(), r3.mag.size());
+    addInto(P + 4*k, len - 4*k, rinf.mag.data(), rinf.mag.size());
+}
+
+// mulToom3()
+// Writes the n+m limb product A*B to P by splitting both operands into three
+// pieces of k = ceil(n/3) limbs, evaluating at the points 0, 1, -1, -2 and
+// infinity, multiplying pointwise and interpolating with Bodrato's sequence.
+// Pre: n >= m > 2*ceil(n/3).
+void mulToom3(Limb* P, const Limb* A, size_t n, const Limb* B, size_t m) {
+    size_t k = (n + 2)/3;
+
+    SignedLimbs a0 = toomPiece(A, k), a1 = toomPiece(A + k, k), a2 = toomPiece(A + 2*k, n - 2*k);
+    SignedLimbs b0 = toomPiece(B, k), b1 = toomPiece(B + k, k), b2 = toomPiece(B + 2*k, m - 2*k);
+
+    // evaluate both operands at 1, -1 and -2
+    SignedLimbs p1, pm1, pm2, q1, qm1, qm2;
+
+    signedSum(p1, a0, a2, 1);
+    signedSum(pm1, p1, a1, -1);
+    signedSum(p1, p1, a1, 1);
+    signedSum(pm2, pm1, a2, 1);
+    signedScale(pm2, 2);
+    signedSum(pm2, pm2, a0, -1);
+
+    signedSum(q1, b0, b2, 1);
+    signedSum(qm1, q1, b1, -1);
+    signedSum(q1, q1, b1, 1);
+    signedSum(qm2, qm1, b2, 1);
+    signedScale(qm2, 2);
+    signedSum(qm2, qm2, b0, -1);
+
+    // pointwise products at 0, 1, -1, -2 and infinity, in parallel for
+    // large operands
+    SignedLimbs r[5];
+    const SignedLimbs* x[5] = { &a0, &p1, &pm1, &pm2, &a2 };
+    const SignedLimbs* y[5] = { &b0, &q1, &qm1, &qm2, &b2 };
+
+    parallelFor(5, multThreads(m), [&](size_t begin, size_t end) {
+        for( size_t i = begin; i < end; i++ ) {
+            signedMult(r[i], *x[i], *y[i]);
+        }
+    });
+
+    toomInterpolate(P, n + m, k, r[0], r[1], r[2], r[3], r[4]);
+}
+
+// sqrToom3()
+// Writes the 2n limb square of A to P with Toom-3: A is evaluated once at
+// 0, 1, -1, -2 and infinity and the five pointwise products are squarings.
+void sqrToom3(Limb* P, const Limb* A, size_t n) {
+    size_t k = (n + 2)/3;
+
+    SignedLimbs a0 = toomPiece(A, k), a1 = toomPiece(A + k, k), a2 = toomPiece(A + 2*k, n - 2*k);
+
+    // evaluate at 1, -1 and -2
+    SignedLimbs p1, pm1, pm2;
+
+    signedSum(p1, a0, a2, 1);
+    signedSum(pm1, p1, a1, -1);
+    signedSum(p1, p1, a1, 1);
+    signedSum(pm2, pm1, a2, 1);
+    signedScale(pm2, 2);
+    signedSum(pm2, pm2, a0, -1);
+
+    // pointwise squares, in parallel for large operands
+    SignedLimbs r[5];
+    const SignedLimbs* x[5] = { &a0, &p1, &pm1, &pm2, &a2 };
+
+    parallelFor(5, multThreads(n), [&](size_t begin, size_t end) {
+        for( size_t i = begin; i < end; i++ ) {
+            signedSquare(r[i], *x[i]);
+        }
+    });
+
+    toomInterpolate(P, 2*n, k, r[0], r[1], r[2], r[3], r[4]);
+}
+
+// powMod()
+// Returns b^e mod MOD. Used by the number-theoretic transform.
+template<Limb MOD>
+Limb powMod(Limb b, DLimb e) {
+    DLimb result = 1;
+    DLimb base = b % MOD;
+
+    while( e > 0 ) {
+        if( e & 1 ) {
+            result = result*base % MOD;
+        }
+        base = base*base % MOD;
+        e >>= 1;
+    }
+
+    return (Limb)result;
+}
+
+// nttTransform()
+// Replaces a (whose size is a power of 2) with its number-theoretic
+// transform modulo MOD, or with the inverse transform if invert is true.
+// Iterative radix-2 Cooley-Tukey with an initial bit-reversal permutation.
+// The butterflies of each pass are spread over threads threads.
+template<Limb MOD>
+void nttTransform(LimbVector& a, bool invert, size_t threads) {
+    size_t len = a.size();
+
+    // bit-reversal permutation
+    for( size_t i = 1, j = 0; i < len; i++ ) {
+        size_t bit = len >> 1;
+        for( ; j & bit; bit >>= 1 ) {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if( i < j ) {
+            std::swap(a[i], a[j]);
+        }
+    }
+
+    LimbVector roots(len/2 + 1);
+
+    for( size_t half = 1; half < len; half <<= 1 ) {
+        // powers of a primitive (2*half)-th root of unity
+        Limb w = powMod<MOD>(3, (MOD - 1)/(2*half));
+        if( invert ) {
+            w = powMod<MOD>(w, MOD - 2);
+        }
+
+        parallelFor(half, threads, [&](size_t begin, size_t end) {
+            DLimb r = powMod<MOD>(w, begin);
+            for( size_t k = begin; k < end; k++ ) {
+                roots[k] = (Limb)r;
+                r = r*w % MOD;
+            }
+        });
+
+        // butterfly number b pairs a[i + k] with a[i + k + half], where
+        // i = (b/half)*2*half and k = b % half
+        parallelFor(len/2, threads, [&](size_t begin, size_t end) {
+            size_t i = (begin/half)*2*half;
+            size_t k = begin % half;
+
+            for( size_t b = begin; b < end; b++ ) {
+                Limb u = a[i + k];
+                Limb v = (Limb)((DLimb)a[i + k + half]*roots[k] % MOD);
+
+                a[i + k] = (u + v >= MOD) ? u + v - MOD : u + v;
+                a[i + k + half] = (u >= v) ? u - v : u + MOD - v;
+
+                if( ++k==half ) {
+                    k = 0;
+                    i += 2*half;
+                }
+            }
+        });
+    }
+
+    if( invert ) {
+        DLimb inv_len = powMod<MOD>((Limb)(len % MOD), MOD - 2);
+
+        parallelFor(len, threads, [&](size_t begin, size_t end) {
+            for( size_t i = begin; i < end; i++ ) {
+                a[i] = (Limb)(a[i]*inv_len % MOD);
+            }
+        });
+    }
+}
+
+// nttConvolve()
+// Overwrites C with the cyclic convolution of A and B modulo MOD, computed
+// with transforms of length len on threads threads. Limbs enter the field
+// as their residues mod MOD. When A and B are the same operand only one
+// forward transform is needed. Used by mulNTT().
+template<Limb MOD>
+void nttConvolve(LimbVector& C, const Limb* A, size_t n, const Limb* B, size_t m, size_t len,
+                 size_t threads) {
+    C.assign(len, 0);
+    for( size_t i = 0; i < n; i++ ) {
+        C[i] = A[i] % MOD;
+    }
+    nttTransform<MOD>(C, false, threads);
+
+    if( A==B && n==m ) {
+        parallelFor(len, threads, [&](size_t begin, size_t end) {
+            for( size_t i = begin; i < end; i++ ) {
+                C[i] = (Limb)((DLimb)C[i]*C[i] % MOD);
+            }
+        });
+    }
+    else {
+        LimbVector fb(len, 0);
+
+        for( size_t i = 0; i < m; i++ ) {
+            fb[i] = B[i] % MOD;
+        }
+        nttTransform<MOD>(fb, false, threads);
+
+        parallelFor(len, threads, [&](size_t begin, size_t end) {
+            for( size_t i = begin; i < end; i++ ) {
+                C[i] = (Limb)((DLimb)C[i]*fb[i] % MOD);
+            }
+        });
+    }
+
+    nttTransform<MOD>(C, true, threads);
+}
+
+// mulNTT()
+// Writes the n+m limb product A*B to P with a three-prime number-theoretic
+// transform. The transform works directly on base 10^9 limbs: each limb is
+// reduced into the three prime fields, the three convolutions are computed
+// independently, and every coefficient is recovered exactly by Chinese
+// remaindering (Garner's method) and split into three base 10^9 digits
+// before two carry passes add them up. All arithmetic is modular, so
+// the result is exact. For large operands the three convolutions run side
+// by side, each with its share of the threads, and the Garner step is
+// spread over all of them; only the final carry passes are serial.
+// Pre: n + m <= NTT_MAX_LENGTH.
+void mulNTT(Limb* P, const Limb* A, size_t n, const Limb* B, size_t m) {
+    size_t len = 1;
+    while( len < n + m - 1 ) {
+        len <<= 1;
+    }
+
+    size_t threads = multThreads(std::min(n, m));
+    LimbVector c1, c2, c3;
+
+    parallelFor(3, threads, [&](size_t begin, size_t end) {
+        size_t inner = (threads > 1) ? threadBudget() : 1;
+
+        for( size_t i = begin; i < end; i++ ) {
+            if( i==0 ) {
+                nttConvolve<NTT_P1>(c1, A, n, B, m, len, inner);
+            }
+            else if( i==1 ) {
+                nttConvolve<NTT_P2>(c2, A, n, B, m, len, inner);
+            }
+            else {
+                nttConvolve<NTT_P3>(c3, A, n, B, m, len, inner);
+            }
+        }
+    });
+
+    // Garner constants
+    const DLimb inv_p1_p2 = powMod<NTT_P2>(NTT_P1, NTT_P2 - 2);
+    const DLimb inv_p1p2_p3 = powMod<NTT_P3>((Limb)((DLimb)NTT_P1*NTT_P2 % NTT_P3), NTT_P3 - 2);
+    const DLimb p1_mod_p3 = NTT_P1 % NTT_P3;
+
+    // overwrite coefficient i with its base 10^9 digits c1[i], c2[i], c3[i]
+    parallelFor(n + m - 1, threads, [&](size_t begin, size_t end) {
+        for( size_t i = begin; i < end; i++ ) {
+            // x = r1 + p1*v2 + p1*p2*v3, with v2 < p2 and v3 < p3
+            DLimb r1 = c1[i];
+            DLimb v2 = (c2[i] + NTT_P2 - r1 % NTT_P2) % NTT_P2*inv_p1_p2 % NTT_P2;
+            DLimb t3 = (r1 + p1_mod_p3*v2) % NTT_P3;
+            DLimb v3 = (c3[i] + NTT_P3 - t3) % NTT_P3*inv_p1p2_p3 % NTT_P3;
+
+            // x = r1 + p1*y with y = v2 + p2*v3 < p2*p3, and splitting y at
+            // BASE keeps every partial product within 64 bits
+            DLimb y = v2 + NTT_P2*v3;
+            DLimb low = r1 + NTT_P1*(y % BASE);                         // < BASE^2
+            DLimb high = NTT_P1*(y / BASE) + low / BASE;                // < BASE^2
+
+            c1[i] = (Limb)(low % BASE);
+            c2[i] = (Limb)(high % BASE);
+            c3[i] = (Limb)(high / BASE);
+        }
+    });
+
+    // P = c1 + c2*BASE + c3*BASE^2, in two passes of the add kernel. The
+    // top digit of c3 would land beyond P and is zero.
+    std::copy(c1.begin(), c1.begin() + (n + m - 1), P);
+    P[n + m - 1] = 0;
+    addInto(P + 1, n + m - 1, c2.data(), n + m - 1);
+    addInto(P + 2, n + m - 2, c3.data(), n + m - 2);
+}
+
+// mulLimbs()
+// Writes the n+m limb product A*B to P, choosing the basecase, Karatsuba,
+// Toom-3 or the NTT according to the size of the shorter operand. Products
+// too long for a single transform go through Toom-3, whose pieces then
+// fit. Unbalanced operands are cut into blocks the size of the shorter
+// one. When A and B are the same operand the product goes to sqrLimbs()
+// instead. P must not alias A or B.
+// Pre: n >= 1, m >= 1.
+void mulLimbs(Limb* P, const Limb* A, size_t n, const Limb* B, size_t m) {
+    if( A==B && n==m ) {
+        sqrLimbs(P, A, n);
+        return;
+    }
+
+    // keep the longer operand in A
+    if( n < m ) {
+        std::swap(A, B);
+        std::swap(n, m);
+    }
+
+    if( m < karatsuba_threshold ) {
+        mulBasecase(P, A, n, B, m);
+    }
+    else if( m >= ntt_threshold && n + m <= NTT_MAX_LENGTH ) {
+        mulNTT(P, A, n, B, m);
+    }
+    else if( m <= (n + 1)/2 ) {
+        // unbalanced: multiply B by each m-limb block of A and accumulate.
+        // For large operands each thread sums a run of blocks into its own
+        // partial product, and the overlapping partials are added at the end.
+        size_t blocks = (n + m - 1)/m;
+        size_t threads = std::min(multThreads(n), blocks);
+        vector<LimbVector> parts(threads);
+
+        parallelFor(threads, threads, [&](size_t begin, size_t end) {
+            for( size_t t = begin; t < end; t++ ) {
+                size_t lo = blocks*t/threads*m;
+                size_t hi = std::min(blocks*(t + 1)/threads*m, n);
+                LimbVector block(2*m);
+
+                parts[t].assign(hi - lo + m, 0);
+
+                for( size_t i = lo; i < hi; i += m ) {
+                    size_t len = std::min(m, hi - i);
+
+                    mulLimbs(block.data(), A + i, len, B, m);
+                    addInto(parts[t].data() + i - lo, hi - i + m, block.data(), len + m);
+                }
+            }
+        });
+
+        std::fill(P, P + n + m, 0);
+
+        for( size_t t = 0; t < threads; t++ ) {
+            size_t lo = blocks*t/threads*m;
+            addInto(P + lo, n + m - lo, parts[t].data(), parts[t].size());
+        }
+    }
+    else if( m < toom3_threshold || m <= 2*((n + 2)/3) ) {
+        mulKaratsuba(P, A, n, B, m);
+    }
+    else {
+        mulToom3(P, A, n, B, m);
+    }
+}
+
+// sqrLimbs()
+// Writes the 2n limb square of A to P, choosing the squaring variant of the
+// basecase, Karatsuba, Toom-3 or the NTT with the same thresholds as
+// mulLimbs(). P must not alias A.
+// Pre: n >= 1.
+void sqrLimbs(Limb* P, const Limb* A, size_t n) {
+    if( n < karatsuba_threshold ) {
+        sqrBasecase(P, A, n);
+    }
+    else if( n >= ntt_threshold && 2*n <= NTT_MAX_LENGTH ) {
+        mulNTT(P, A, n, A, n);
+    }
+    else if( n < toom3_threshold ) {
+        sqrKaratsuba(P, A, n);
+    }
+    else {
+        sqrToom3(P, A, n);
+    }
+}
+
+// multLimbs()
+// Overwrites P with the magnitude A * B. P must not alias A or B. Used by
+// mult().
+void multLimbs(LimbVector& P, const LimbVector& A, const LimbVector& B) {
+    if( A.empty() || B.empty() ) {
+        P.clear();
+        return;
+    }
+
+    P.resize(A.size() + B.size());
+    mulLimbs(P.data(), A.data(), A.size(), B.data(), B.size());
+    normalizeLimbs(P);
+}
+
+// mulSmallLimbs()
+// Overwrites P with the magnitude A*k in a single carry pass. P may alias A.
+// Pre: 0 < k < BASE.
+void mulSmallLimbs(LimbVector& P, const LimbVector& A, Limb k) {
+    size_t n = A.size();
+
+    P.resize(n);
+
+    Limb carry = limbKernels().mul(P.data(), A.data(), n, k, 0);
+    if( carry ) {
+        P.push_back(carry);
+    }
+}
+
+// addmulSmallLimbs()
+// Overwrites R with the magnitude R + A*k in a single carry pass. R must not
+// alias A. Used by addmul().
+// Pre: 0 < k < BASE.
+void addmulSmallLimbs(LimbVector& R, const LimbVector& A, Limb k) {
+    size_t n = A.size();
+    DLimb carry = 0;
+
+    if( R.size() < n + 1 ) {
+        R.resize(n + 1, 0);
+    }
+
+    for( size_t i = 0; i < n; i++ ) {
+        DLimb t = R[i] + (DLimb)A[i]*k + carry;     // < BASE^2, no overflow
+        R[i] = (Limb)(t % BASE);
+        carry = t / BASE;
+    }
+
+    for( size_t i = n; carry != 0; i++ ) {
+        if( i==R.size() ) {
+            R.push_back(0);
+        }
+
+        DLimb t = R[i] + carry;
+        R[i] = (Limb)(t % BASE);
+        carry = t / BASE;
+    }
+
+    normalizeLimbs(R);
+}
+
+// submulSmallLimbs()
+// Overwrites R with the magnitude |R - A*k| in a single borrow pass and
+// returns the sign of R - A*k. R must not alias A. Used by addmul().
+// Pre: 0 < k < BASE.
+int submulSmallLimbs(LimbVector& R, const LimbVector& A, Limb k) {
+    size_t n = A.size();
+    DLimb borrow = 0;
+
+    if( R.size() < n + 1 ) {
+        R.resize(n + 1, 0);
+    }
+
+    for( size_t i = 0; i < R.size() && (i < n || borrow != 0); i++ ) {
+        DLimb t = ((i < n) ? (DLimb)A[i]*k : 0) + borrow;
+        Limb low = (Limb)(t % BASE);
+
+        borrow = t / BASE;
+        if( R[i] >= low ) {
+            R[i] -= low;
+        }
+        else {
+            R[i] += BASE - low;
+            borrow++;
+        }
+    }
+
+    int sign = 1;
+
+    // a borrow out of the top limb means A*k > R, and R now holds
+    // BASE^len - (A*k - R): take the complement to recover the magnitude
+    if( borrow != 0 ) {
+        size_t i = 0;
+
+        sign = -1;
+        while( R[i]==0 ) {
+            i++;
+        }
+        R[i] = BASE - R[i];
+        for( i++; i < R.size(); i++ ) {
+            R[i] = BASE - 1 - R[i];
+        }
+    }
+
+    normalizeLimbs(R);
+
+    return R.empty() ? 0 : sign;
+}
+
+
+// topLimbLength()
+// Returns the number of decimal digits in the non-zero limb x. Used by
+// to_string() and operator<<().
+int topLimbLength(Limb x) {
+    int len = 1;
+
+    while( x >= 10 ) {
+        x /= 10;
+        len++;
+    }
+
+    return len;
+}
+
+// writeDecimal()
+// Writes the low len decimal digits of x to out, most significant first and
+// padded with leading zeros. Used by to_string() and operator<<().
+void writeDecimal(char* out, Limb x, int len) {
+    static const char pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    // two digits per division
+    int i = len - 1;
+    for( ; i > 0; i -= 2 ) {
+        Limb r = x % 100;
+        out[i] = pairs[2*r + 1];
+        out[i - 1] = pairs[2*r];
+        x /= 100;
+    }
+
+    if( i==0 ) {
+        out[0] = (char)('0' + x);
+    }
+}
+
+// shiftLimbs()
+// Prepends p zero limbs to L, multiplying L by BASE^p. Used by the division
+// routines.
+void shiftLimbs(LimbVector& L, size_t p) {
+    if( !L.empty() ) {
+        L.insert(L.begin(), p, 0);
+    }
+}
+
+// powerOfBase()
+// Overwrites L with BASE^p. Used by the division routines.
+void powerOfBase(LimbVector& L, size_t p) {
+    L.assign(p + 1, 0);
+    L[p] = 1;
+}
+
+// divSmallLimbs()
+// Overwrites Q with the magnitude A / d and returns A % d. Q may alias A.
+// Pre: 0 < d < BASE. Used by div(long), mod(long) and divmodLimbs().
+Limb divSmallLimbs(LimbVector& Q, const LimbVector& A, Limb d) {
+    DLimb rem = 0;
+
+    Q.resize(A.size());
+    for( size_t i = A.size(); i-- > 0; ) {
+        DLimb cur = rem*BASE + A[i];
+        Q[i] = (Limb)(cur / d);
+        rem = cur % d;
+    }
+
+    normalizeLimbs(Q);
+    return (Limb)rem;
+}
+
+// divKnuth()
+// Overwrites Q and R with the quotient and remainder of the magnitudes A / B
+// using Knuth's Algorithm D (TAOCP vol. 2, 4.3.1) in base 10^9. Q and R must
+// not alias A or B. Pre: B.size() >= 2. Used by divmodLimbs().
+void divKnuth(LimbVector& Q, LimbVector& R, const LimbVector& A, const LimbVector& B) {
+    size_t n = A.size();
+    size_t m = B.size();
+
+    if( compareLimbs(A, B) < 0 ) {
+        Q.clear();
+        R = A;
+        return;
+    }
+
+    // D1: normalize so the top limb of the divisor is at least BASE/2
+    Limb d = BASE/(B[m - 1] + 1);
+    LimbVector u(n + 1, 0), v(m, 0);
+    DLimb carry = 0;
+
+    for( size_t i = 0; i < n; i++ ) {
+        DLimb t = (DLimb)A[i]*d + carry;
+        u[i] = (Limb)(t % BASE);
+        carry = t / BASE;
+    }
+    u[n] = (Limb)carry;
+
+    carry = 0;
+    for( size_t i = 0; i < m; i++ ) {
+        DLimb t = (DLimb)B[i]*d + carry;
+        v[i] = (Limb)(t % BASE);
+        carry = t / BASE;
+    }
+
+    Q.assign(n - m + 1, 0);
+
+    // D2-D7: one quotient limb per iteration, most significant first
+    for( size_t j = n - m + 1; j-- > 0; ) {
+        DLimb num = (DLimb)u[j + m]*BASE + u[j + m - 1];
+        DLimb qhat = num / v[m - 1];
+        DLimb rhat = num % v[m - 1];
+
+        // D3: qhat is at most 2 too large; fix it using the next limb
+        while( qhat >= BASE || qhat*v[m - 2] > rhat*BASE + u[j + m - 2] ) {
+            qhat--;
+            rhat += v[m - 1];
+            if( rhat >= BASE ) {
+                break;
+            }
+        }
+
+        // D4: u[j..j+m] -= qhat*v
+        std::int64_t borrow = 0;
+        carry = 0;
+        for( size_t i = 0; i < m; i++ ) {
+            DLimb p = qhat*v[i] + carry;
+            carry = p / BASE;
+
+            std::int64_t t = (std::int64_t)u[i + j] - (std::int64_t)(p % BASE) - borrow;
+            borrow = (t < 0);
+            u[i + j] = (Limb)(borrow ? t + BASE : t);
+        }
+
+        std::int64_t t = (std::int64_t)u[j + m] - (std::int64_t)carry - borrow;
+        borrow = (t < 0);
+        u[j + m] = (Limb)(borrow ? t + BASE : t);
+
+        // D6: qhat was one too large, add v back
+        if( borrow ) {
+            qhat--;
+
+            Limb c = 0;
+            for( size_t i = 0; i < m; i++ ) {
+                Limb sum = u[i + j] + v[i] + c;
+                c = (sum >= BASE);
+                u[i + j] = c ? sum - BASE : sum;
+            }
+            u[j + m] = (u[j + m] + c) % BASE;   // the carry out cancels the borrow
+        }
+
+        Q[j] = (Limb)qhat;
+    }
+
+    // D8: unnormalize the remainder
+    u.resize(m);
+    normalizeLimbs(Q);
+    normalizeLimbs(u);
+    divSmallLimbs(R, u, d);
+}
+
+// reciprocalLimbs()
+// Overwrites X with floor(BASE^(2m) / B), where m = B.size(). Small divisors
+// go through Algorithm D; larger ones take one Newton-Raphson step
+//    X1 = X0 + X0*(BASE^(2m) - B*X0) / BASE^(2m)
+// from the reciprocal of the top half of B, then a final exact correction.
+// Pre: B is non-zero. Used by divNewton().
+void reciprocalLimbs(LimbVector& X, const LimbVector& B) {
+    size_t m = B.size();
+    LimbVector R, pow;
+
+    if( m < newton_threshold || m < 6 ) {
+        powerOfBase(pow, 2*m);
+        if( m==1 ) {
+            divSmallLimbs(X, pow, B[0]);
+        }
+        else {
+            divKnuth(X, R, pow, B);
+        }
+        return;
+    }
+
+    // reciprocal of the top l limbs, scaled up to an approximation of X. Two
+    // guard limbs keep the error after one Newton step within a few units
+    // even when the top limb of B is small.
+    size_t l = (m + 1)/2 + 2;
+    LimbVector top(B.end() - l, B.end());
+    LimbVector X0;
+
+    reciprocalLimbs(X0, top);
+    shiftLimbs(X0, m - l);
+
+    // Newton step, with the residual BASE^(2m) - B*X0 carried as a signed value
+    SignedLimbs x0{ 1, X0 }, b{ 1, B }, e, t, d;
+
+    powerOfBase(e.mag, 2*m);
+    e.sign = 1;
+    signedMult(t, b, x0);
+    signedSum(e, e, t, -1);
+    signedMult(d, x0, e);
+
+    if( d.mag.size() > 2*m ) {
+        d.mag.erase(d.mag.begin(), d.mag.begin() + 2*m);
+    }
+    else {
+        d.mag.clear();
+        d.sign = 0;
+    }
+    signedSum(x0, x0, d, 1);
+
+    // final correction so that 0 <= BASE^(2m) - B*X < B
+    SignedLimbs one{ 1, LimbVector(1, 1) };
+
+    signedMult(t, b, x0);
+    powerOfBase(e.mag, 2*m);
+    e.sign = 1;
+    signedSum(e, e, t, -1);
+
+    while( e.sign < 0 ) {
+        signedSum(x0, x0, one, -1);
+        signedSum(e, e, b, 1);
+    }
+    while( e.sign > 0 && compareLimbs(e.mag, B) >= 0 ) {
+        signedSum(x0, x0, one, 1);
+        signedSum(e, e, b, -1);
+    }
+
+    X = x0.mag;
+}
+
+// barrettLimbs()
+// Overwrites Q and R with the quotient and remainder of the magnitudes A / B,
+// given the reciprocal X = floor(BASE^(2m)/B) with m = B.size(). The
+// estimate floor(A*X / BASE^(2m)) is at most 2 too small and is corrected
+// by subtraction. Q and R must not alias A. Pre: A < B*BASE^m. Used by
+// divNewton() and by modpow() for moduli Montgomery cannot handle.
+void barrettLimbs(LimbVector& Q, LimbVector& R, const LimbVector& A, const LimbVector& B, const LimbVector& X) {
+    size_t m = B.size();
+    LimbVector prod;
+    const LimbVector one(1, 1);
+
+    // Q = floor(A*X / BASE^(2m))
+    multLimbs(prod, A, X);
+    if( prod.size() > 2*m ) {
+        Q.assign(prod.begin() + 2*m, prod.end());
+    }
+    else {
+        Q.clear();
+    }
+
+    // R = A - Q*B, then bring R below B
+    multLimbs(prod, Q, B);
+    diffLimbs(R, A, prod);
+
+    while( compareLimbs(R, B) >= 0 ) {
+        diffLimbs(R, R, B);
+        sumLimbs(Q, Q, one);
+    }
+}
+
+// divNewton()
+// Overwrites Q and R with the quotient and remainder of the magnitudes A / B
+// using a precomputed reciprocal X = floor(BASE^(2m)/B) and the fast
+// multiplier. A is consumed in blocks of m limbs, most significant first;
+// each block's quotient estimate is at most 2 too small. Q and R must not
+// alias A or B. Used by divmodLimbs().
+void divNewton(LimbVector& Q, LimbVector& R, const LimbVector& A, const LimbVector& B) {
+    size_t n = A.size();
+    size_t m = B.size();
+    LimbVector X, cur, q;
+
+    reciprocalLimbs(X, B);
+
+    Q.assign(n, 0);
+    R.clear();
+
+    // the first block takes the leftover limbs so the rest are exactly m long
+    size_t pos = n;
+    size_t first = (n % m==0) ? m : n % m;
+
+    while( pos > 0 ) {
+        size_t len = (pos==n) ? first : m;
+        pos -= len;
+
+        // cur = R*BASE^len + A[pos..pos+len), which is less than B*BASE^m
+        cur.assign(A.begin() + pos, A.begin() + pos + len);
+        cur.insert(cur.end(), R.begin(), R.end());
+        normalizeLimbs(cur);
+
+        barrettLimbs(q, R, cur, B, X);
+        std::copy(q.begin(), q.end(), Q.begin() + pos);
+    }
+
+    normalizeLimbs(Q);
+}
+
+// divmodLimbs()
+// Overwrites Q and R with the quotient and remainder of the magnitudes A / B,
+// dispatching on the length of B: one limb uses divSmallLimbs(), short
+// divisors use Algorithm D and long ones use the Newton reciprocal. Q and R
+// must not alias A or B. Pre: B is non-zero.
+void divmodLimbs(LimbVector& Q, LimbVector& R, const LimbVector& A, const LimbVector& B) {
+    if( compareLimbs(A, B) < 0 ) {
+        Q.clear();
+        R = A;
+    }
+    else if( B.size()==1 ) {
+        Limb r = divSmallLimbs(Q, A, B[0]);
+        R.assign(1, r);
+        normalizeLimbs(R);
+    }
+    else if( B.size() < newton_threshold || A.size() < B.size() + 2 ) {
+        divKnuth(Q, R, A, B);
+    }
+    else {
+        divNewton(Q, R, A, B);
+    }
+}
+
+
+// trailingZeros()
+// Returns the number of trailing zero bits of x.
+// Pre: x != 0.
+int trailingZeros(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int k = 0;
+    while( (x & 1)==0 ) {
+        x >>= 1;
+        k++;
+    }
+    return k;
+#endif
+}
+
+// binaryGcd()
+// Returns gcd(u, v) by Stein's binary algorithm, using only shifts and
+// subtractions. Used by gcd() once both operands fit in a machine word.
+std::uint64_t binaryGcd(std::uint64_t u, std::uint64_t v) {
+    if( u==0 || v==0 ) {
+        return u | v;
+    }
+
+    int shift = trailingZeros(u | v);
+
+    u >>= trailingZeros(u);
+    do {
+        v >>= trailingZeros(v);
+        if( u > v ) {
+            std::swap(u, v);
+        }
+        v -= u;
+    } while( v != 0 );
+
+    return u << shift;
+}
+
+// wordValue()
+// Returns the value of the magnitude L, which has at most two limbs.
+std::uint64_t wordValue(const LimbVector& L) {
+    std::uint64_t x = 0;
+
+    for( size_t i = L.size(); i-- > 0; ) {
+        x = x*BASE + L[i];
+    }
+    return x;
+}
+
+// setWordValue()
+// Overwrites L with the limbs of the magnitude x.
+void setWordValue(LimbVector& L, std::uint64_t x) {
+    L.clear();
+    for( ; x != 0; x /= BASE ) {
+        L.push_back((Limb)(x % BASE));
+    }
+}
+
+// leadingDigits()
+// Returns floor(L / 10^(9(n-2) - e)): limbs n-1 and n-2 of L followed by the
+// top e digits of limb n-3. Limbs past the end of L count as 0.
+// Pre: n >= 3, 0 <= e < 9
+std::int64_t leadingDigits(const LimbVector& L, size_t n, int e) {
+    std::int64_t scale = 1;
+
+    for( int i = 0; i < e; i++ ) {
+        scale *= 10;
+    }
+
+    std::int64_t x = 0;
+    for( size_t i = n - 1; i >= n - 2; i-- ) {
+        x = x*BASE + ((i < L.size()) ? L[i] : 0);
+    }
+
+    return x*scale + ((n - 3 < L.size()) ? L[n - 3] : 0)/(BASE/scale);
+}
+
+// lehmerMatrix()
+// Runs Euclid's algorithm on the leading 18 digits of the magnitudes A >= B
+// for as long as its quotients provably match those of A and B themselves,
+// and collects the steps in m = { u0, v0, u1, v1 }, so that A*u0 + B*v0 and
+// A*u1 + B*v1 are the remainders those steps reach. Every entry stays below
+// BASE in absolute value. Returns false if not even one step was certain.
+// Pre: A.size() >= 3
+bool lehmerMatrix(const LimbVector& A, const LimbVector& B, std::int64_t m[4]) {
+    size_t n = A.size();
+    int e = 9 - topLimbLength(A[n - 1]);
+    std::int64_t x = leadingDigits(A, n, e);
+    std::int64_t y = leadingDigits(B, n, e);
+    std::int64_t u0 = 1, v0 = 0, u1 = 0, v1 = 1;
+
+    // the true remainders lie between x + u0 and x + v0 (y + u1 and y + v1)
+    // in the leading digits, so a quotient is certain when both ends agree
+    while( y + u1 > 0 && y + v1 > 0 ) {
+        std::int64_t q = (x + u0)/(y + u1);
+
+        if( q != (x + v0)/(y + v1) ) {
+            break;
+        }
+
+        std::int64_t u2 = u0 - q*u1;
+        std::int64_t v2 = v0 - q*v1;
+        if( u2 <= -(std::int64_t)BASE || u2 >= BASE || v2 <= -(std::int64_t)BASE || v2 >= BASE ) {
+            break;
+        }
+
+        std::int64_t r = x - q*y;
+        x = y; y = r;
+        u0 = u1; u1 = u2;
+        v0 = v1; v1 = v2;
+    }
+
+    m[0] = u0; m[1] = v0;
+    m[2] = u1; m[3] = v1;
+
+    return v0 != 0;
+}
+
+// linearLimbs()
+// Overwrites R with the magnitude u*X + v*Y in a single signed carry pass.
+// R must not alias X or Y.
+// Pre: |u|, |v| < BASE and u*X + v*Y >= 0
+void linearLimbs(LimbVector& R, const LimbVector& X, std::int64_t u, const LimbVector& Y, std::int64_t v) {
+    size_t n = std::max(X.size(), Y.size());
+    std::int64_t carry = 0;
+
+    R.resize(n);
+    for( size_t i = 0; i < n; i++ ) {
+        std::int64_t t = carry;             // |t| < 2*BASE^2, no overflow
+
+        if( i < X.size() ) {
+            t += u*X[i];
+        }
+        if( i < Y.size() ) {
+            t += v*Y[i];
+        }
+
+        std::int64_t r = t % (std::int64_t)BASE;
+        if( r < 0 ) {
+            r += BASE;
+        }
+        R[i] = (Limb)r;
+        carry = (t - r)/(std::int64_t)BASE;
+    }
+
+    for( ; carry > 0; carry /= BASE ) {
+        R.push_back((Limb)(carry % BASE));
+    }
+
+    normalizeLimbs(R);
+}
+
+// logMagnitude()
+// Returns the natural logarithm of the non-zero magnitude L, from its
+// leading three limbs.
+long double logMagnitude(const LimbVector& L) {
+    size_t n = L.size();
+    size_t used = std::min(n, (size_t)3);
+    long double top = 0;
+
+    for( size_t i = n; i-- > n - used; ) {
+        top = top*BASE + L[i];
+    }
+
+    return std::log(top) + (long double)(n - used)*std::log((long double)BASE);
+}
+
+// primeSieve()
+// Returns a table marking the primes below n, by the sieve of
+// Eratosthenes.
+vector<bool> primeSieve(size_t n) {
+    vector<bool> prime(n, true);
+
+    for( size_t i = 0; i < std::min(n, (size_t)2); i++ ) {
+        prime[i] = false;
+    }
+    for( size_t d = 2; d*d < n; d++ ) {
+        if( prime[d] ) {
+            for( size_t m = d*d; m < n; m += d ) {
+                prime[m] = false;
+            }
+        }
+    }
+    return prime;
+}
+
+// isPrimeWord()
+// Returns true if and only if x is prime, by trial division.
+bool isPrimeWord(std::uint64_t x) {
+    if( x < 4 ) {
+        return x >= 2;
+    }
+    if( x % 2==0 ) {
+        return false;
+    }
+    for( std::uint64_t d = 3; d*d <= x; d += 2 ) {
+        if( x % d==0 ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// powModWord()
+// Returns b^e mod m.
+// Pre: 0 < m < 2^32
+std::uint64_t powModWord(std::uint64_t b, std::uint64_t e, std::uint64_t m) {
+    std::uint64_t r = 1 % m;
+
+    for( b %= m; e > 0; e >>= 1 ) {
+        if( e & 1 ) {
+            r = r*b % m;
+        }
+        b = b*b % m;
+    }
+    return r;
+}
+
+// SquareResidues
+// Tables of the squares modulo 512, 63, 65 and 11, the moduli
+// isPerfectSquare() screens with: entry r is true if and only if r is a
+// square modulo the table's length.
+struct SquareResidues{
+    bool mod512[512];
+    bool mod63[63];
+    bool mod65[65];
+    bool mod11[11];
+
+    SquareResidues() : mod512(), mod63(), mod65(), mod11() {
+        for( int i = 0; i < 512; i++ ) {
+            mod512[i*i % 512] = true;
+            mod63[i*i % 63] = true;
+            mod65[i*i % 65] = true;
+            mod11[i*i % 11] = true;
+        }
+    }
+};
+
+// productOf()
+// Returns the product of P[lo], ..., P[hi-1], multiplied as a balanced tree
+// so the large products are between operands of equal length.
+// Pre: lo < hi
+BigInteger productOf(const vector<long>& P, size_t lo, size_t hi) {
+    if( hi - lo==1 ) {
+        return BigInteger(P[lo]);
+    }
+
+    size_t mid = lo + (hi - lo)/2;
+    return productOf(P, lo, mid).mult(productOf(P, mid, hi));
+}
+
+// residuesMod()
+// Sets R[i] to N mod P[i] for each i in [lo, hi). N is reduced modulo the
+// product of each half of the range and the halves recurse, so all of N
+// goes through two long divisions rather than one pass per modulus, and
+// each level below works on remainders half as long.
+// Pre: N >= 0, each P[i] is in [2, BASE)
+void residuesMod(const BigInteger& N, const vector<long>& P, size_t lo, size_t hi, vector<long>& R) {
+    if( hi - lo <= 8 ) {
+        for( size_t i = lo; i < hi; i++ ) {
+            R[i] = N.mod(P[i]);
+        }
+        return;
+    }
+
+    size_t mid = lo + (hi - lo)/2;
+    residuesMod(N.mod(productOf(P, lo, mid)), P, lo, mid, R);
+    residuesMod(N.mod(productOf(P, mid, hi)), P, mid, hi, R);
+}
+
+
+// exponentBits()
+// Returns the binary digits of the magnitude E, least significant first.
+// Used by modpow().
+vector<unsigned char> exponentBits(const LimbVector& E) {
+    vector<unsigned char> bits;
+    LimbVector q = E;
+
+    // peel off 29 bits at a time, since 2^29 < BASE
+    while( !q.empty() ) {
+        Limb chunk = divSmallLimbs(q, q, (Limb)1 << 29);
+
+        for( int i = 0; i < 29; i++ ) {
+            bits.push_back((chunk >> i) & 1);
+        }
+    }
+
+    while( !bits.empty() && bits.back()==0 ) {
+        bits.pop_back();
+    }
+
+    return bits;
+}
+
+// windowSize()
+// Returns the sliding-window width that minimises the expected number of
+// multiplications for an exponent of nbits bits.
+int windowSize(size_t nbits) {
+    if( nbits > 671 ) return 6;
+    if( nbits > 239 ) return 5;
+    if( nbits > 79 ) return 4;
+    if( nbits > 23 ) return 3;
+    if( nbits > 7 ) return 2;
+    return 1;
+}
+
+// windowPow()
+// Returns x^e, where e is given by its bits (least significant first, top
+// bit set), using left-to-right sliding-window exponentiation. Only the odd
+// powers x, x^3, ..., x^(2^w - 1) are precomputed. mul(a, b) must return
+// the product a*b in whatever representation T uses. Used by pow() and
+// modpow().
+template<class T, class MulOp>
+T windowPow(const T& x, const vector<unsigned char>& bits, MulOp mul) {
+    int w = windowSize(bits.size());
+
+    // odd powers of x
+    vector<T> odd(1, x);
+    if( w > 1 ) {
+        T x2 = mul(x, x);
+        for( int i = 1; i < (1 << (w - 1)); i++ ) {
+            odd.push_back(mul(odd.back(), x2));
+        }
+    }
+
+    T result;
+    bool started = false;
+    long i = (long)bits.size() - 1;
+
+    while( i >= 0 ) {
+        if( bits[i]==0 ) {
+            result = mul(result, result);
+            i--;
+            continue;
+        }
+
+        // longest window bits[j..i] of at most w bits that ends in a 1
+        long j = std::max(i - w + 1, 0L);
+        while( bits[j]==0 ) {
+            j++;
+        }
+
+        int value = 0;
+        for( long k = i; k >= j; k-- ) {
+            value = (value << 1) | bits[k];
+            if( started ) {
+                result = mul(result, result);
+            }
+        }
+
+        result = started ? mul(result, odd[value >> 1]) : odd[value >> 1];
+        started = true;
+        i = j - 1;
+    }
+
+    return result;
+}
+
+// montgomeryReduce()
+// Overwrites T with T * BASE^(-k) mod M (Montgomery's REDC in base 10^9),
+// where k = M.size() and minv = -M^(-1) mod BASE. Pre: T < M*BASE^k.
+// Used by MontgomeryContext.
+void montgomeryReduce(LimbVector& T, const LimbVector& M, Limb minv) {
+    size_t k = M.size();
+    T.resize(2*k + 1, 0);
+
+    for( size_t i = 0; i < k; i++ ) {
+        // choose u so that the limb at position i becomes zero
+        DLimb u = (DLimb)T[i]*minv % BASE;
+        DLimb carry = 0;
+
+        for( size_t j = 0; j < k; j++ ) {
+            DLimb t = T[i + j] + u*M[j] + carry;
+            T[i + j] = (Limb)(t % BASE);
+            carry = t / BASE;
+        }
+
+        for( size_t j = i + k; carry != 0; j++ ) {
+            DLimb t = T[j] + carry;
+            T[j] = (Limb)(t % BASE);
+            carry = t / BASE;
+        }
+    }
+
+    // divide by BASE^k, leaving a value below 2M
+    T.erase(T.begin(), T.begin() + k);
+    normalizeLimbs(T);
+
+    if( compareLimbs(T, M) >= 0 ) {
+        diffLimbs(T, T, M);
+    }
+}
+
+
+// storeLE()
+// Writes the low bytes bytes of x to out, least significant first.
+void storeLE(unsigned char* out, std::uint64_t x, int bytes) {
+    for( int i = 0; i < bytes; i++ ) {
+        out[i] = (unsigned char)(x >> (8*i));
+    }
+}
+
+// loadLE()
+// Returns the bytes-byte little-endian value at in.
+std::uint64_t loadLE(const unsigned char* in, int bytes) {
+    std::uint64_t x = 0;
+
+    for( int i = bytes; i-- > 0; ) {
+        x = (x << 8) | in[i];
+    }
+    return x;
+}
+
+// hostIsLittleEndian()
+// Returns true if limbs in memory already have the record's byte order.
+bool hostIsLittleEndian() {
+    const std::uint32_t probe = 1;
+    unsigned char first;
+
+    std::copy((const unsigned char*)&probe, (const unsigned char*)&probe + 1, &first);
+    return first==1;
+}
+
+// writeRecordHeader()
+// Writes the RECORD_HEADER byte header of a record with the given sign and
+// limb count to out.
+void writeRecordHeader(unsigned char* out, int sign, size_t count) {
+    out[0] = RECORD_MAGIC[0];
+    out[1] = RECORD_MAGIC[1];
+    out[2] = RECORD_VERSION;
+    out[3] = (unsigned char)(signed char)sign;
+    storeLE(out + 4, BASE, 4);
+    storeLE(out + 8, count, 8);
+}
+
+// readRecordHeader()
+// Checks the RECORD_HEADER byte header at in, sets sign from it and returns
+// the limb count, which is at most LimbVector::MAX_LIMBS. fn names the
+// caller in error messages.
+size_t readRecordHeader(const unsigned char* in, int& sign, const char* fn) {
+    if( in[0]!=RECORD_MAGIC[0] || in[1]!=RECORD_MAGIC[1] ) {
+        throw std::invalid_argument(std::string("BigInteger: ") + fn + ": not a BigInteger record");
+    }
+    if( in[2]!=RECORD_VERSION ) {
+        throw std::invalid_argument(std::string("BigInteger: ") + fn + ": unsupported record version");
+    }
+    if( loadLE(in + 4, 4)!=BASE ) {
+        throw std::invalid_argument(std::string("BigInteger: ") + fn + ": unsupported limb base");
+    }
+
+    sign = (signed char)in[3];
+    std::uint64_t count = loadLE(in + 8, 8);
+
+    if( sign < -1 || sign > 1 || (sign==0)!=(count==0) || count > LimbVector::MAX_LIMBS
+        || count > (SIZE_MAX - RECORD_HEADER)/4 ) {
+        throw std::invalid_argument(std::string("BigInteger: ") + fn + ": malformed record header");
+    }
+
+    return (size_t)count;
+}
+
+// readRecordLimbs()
+// Copies the count little-endian limbs at in to L, checking that each is
+// below BASE. The limbs may be one chunk of a longer record, so the caller
+// checks the record's top limb. fn names the caller in error messages.
+void readRecordLimbs(LimbVector& L, const unsigned char* in, size_t count, const char* fn) {
+    L.resize(count);
+
+    if( hostIsLittleEndian() ) {
+        std::copy(in, in + 4*count, (unsigned char*)L.data());
+    }
+    else {
+        for( size_t i = 0; i < count; i++ ) {
+            L[i] = (Limb)loadLE(in + 4*i, 4);
+        }
+    }
+
+    for( size_t i = 0; i < count; i++ ) {
+        if( L[i] >= BASE ) {
+            throw std::invalid_argument(std::string("BigInteger: ") + fn + ": limb out of range");
+        }
+    }
+}
+
+
+// BigInteger Arithmetic operations -------------------------------------------
+
+// add()
+// Returns a BigInteger representing the sum of this and N.
+BigInteger BigInteger::add(const BigInteger& N) const {
+    BigInteger S;                               // resulting sum
+
+    // cases based on the signs of this BigInteger and N
+    if( N.signum==0 ) {
+        return *this;
+    }
+    else if( signum==0 ) {
+        return N;
+    }
+    else if( signum==N.signum ) {
+        sumLimbs(S.digits, digits, N.digits);   // same sign: add magnitudes
+        S.signum = signum;
+    }
+    else {
+        // opposite signs: subtract the smaller magnitude from the larger
+        int cmp = compareLimbs(digits, N.digits);
+
+        if( cmp > 0 ) {
+            diffLimbs(S.digits, digits, N.digits);
+            S.signum = signum;
+        }
+        else if( cmp < 0 ) {
+            diffLimbs(S.digits, N.digits, digits);
+            S.signum = N.signum;
+        }
+    }
+
+    return S;
+}
+
+// add()
+// Returns a BigInteger representing the sum of this and k. k is laid out in
+// at most three inline limbs, so this costs one pass over this and no heap
+// temporaries.
+BigInteger BigInteger::add(long k) const {
+    return add(BigInteger(k));
+}
+
+// sub()
+// Returns a BigInteger representing the difference of this and N.
+BigInteger BigInteger::sub(const BigInteger& N) const {
+    BigInteger D;                               // resulting difference
+
+    // cases based on the signs of this BigInteger and N
+    if( N.signum==0 ) {
+        return *this;
+    }
+    else if( signum==0 ) {
+        D = N;
+        D.negate();
+    }
+    else if( signum!=N.signum ) {
+        sumLimbs(D.digits, digits, N.digits);   // opposite signs: add magnitudes
+        D.signum = signum;
+    }
+    else {
+        // same sign: subtract the smaller magnitude from the larger
+        int cmp = compareLimbs(digits, N.digits);
+
+        if( cmp > 0 ) {
+            diffLimbs(D.digits, digits, N.digits);
+            D.signum = signum;
+        }
+        else if( cmp < 0 ) {
+            diffLimbs(D.digits, N.digits, digits);
+            D.signum = -signum;
+        }
+    }
+
+    return D;
+}
+
+// mult()
+// Returns a BigInteger representing the product of this and N.
+BigInteger BigInteger::mult(const BigInteger& N) const {
+    BigInteger P = BigInteger();                // resulting product
+
+    if( signum==0 || N.signum==0 ) {
+        return P;
+    }
+
+    multLimbs(P.digits, digits, N.digits);
+    P.signum = signum * N.signum;               // set the sign of the resulting product
+
+    return P;
+}
+
+// mult()
+// Returns a BigInteger representing the product of this and k, formed in a
+// single carry pass when |k| fits in one limb.
+BigInteger BigInteger::mult(long k) const {
+    BigInteger P;
+
+    if( signum==0 || k==0 ) {
+        return P;
+    }
+
+    unsigned long mag = (k < 0) ? 0UL - (unsigned long)k : (unsigned long)k;
+
+    // factors of two or three limbs go through the basecase multiplier
+    if( mag >= BASE ) {
+        return mult(BigInteger(k));
+    }
+
+    mulSmallLimbs(P.digits, digits, (Limb)mag);
+    P.signum = signum*((k < 0) ? -1 : 1);
+
+    return P;
+}
+
+// addmul()
+// Adds the product A*k to this in place. When |k| fits in one limb the
+// product is folded into this during a single carry (or borrow) pass and
+// never materialised.
+void BigInteger::addmul(const BigInteger& A, long k) {
+    if( A.signum==0 || k==0 ) {
+        return;
+    }
+
+    unsigned long mag = (k < 0) ? 0UL - (unsigned long)k : (unsigned long)k;
+
+    if( mag >= BASE || &A==this ) {
+        addInPlace(A.mult(k), 1);
+        return;
+    }
+
+    int psign = A.signum*((k < 0) ? -1 : 1);
+
+    if( signum==0 ) {
+        mulSmallLimbs(digits, A.digits, (Limb)mag);
+        signum = psign;
+    }
+    else if( signum==psign ) {
+        addmulSmallLimbs(digits, A.digits, (Limb)mag);
+    }
+    else {
+        signum *= submulSmallLimbs(digits, A.digits, (Limb)mag);
+    }
+}
+
+// assignLinear()
+// Overwrites this with k[0]*X[0] + ... + k[n-1]*X[n-1]. Up to LINEAR_TERMS
+// terms are summed per pass, each limb of the result taking every term's
+// scaled limb and the signed carry at once; longer sums carry this forward
+// as the first term of the next pass. A negative total shows up as a
+// negative final carry and is complemented at the end. Scalars of a limb or
+// more are applied to their term beforehand.
+void BigInteger::assignLinear(const BigInteger* const X[], const long k[], std::size_t n) {
+    const size_t LINEAR_TERMS = 8;              // keeps every limb sum below 2^63
+
+    size_t next = 0;
+    bool first = true;
+
+    while( first || next < n ) {
+        const BigInteger* term[LINEAR_TERMS];
+        std::int64_t coef[LINEAR_TERMS];
+        BigInteger scaled[LINEAR_TERMS];
+        size_t count = 0;
+        size_t width = 0;
+
+        // after the first pass, this holds the sum so far
+        if( !first && signum != 0 ) {
+            term[count] = this;
+            coef[count++] = signum;
+        }
+
+        for( ; next < n && count < LINEAR_TERMS; next++ ) {
+            if( X[next]->signum==0 || k[next]==0 ) {
+                continue;
+            }
+
+            unsigned long mag = (k[next] < 0) ? 0UL - (unsigned long)k[next] : (unsigned long)k[next];
+
+            if( mag >= BASE ) {
+                scaled[count] = X[next]->mult(k[next]);
+                term[count] = &scaled[count];
+                coef[count] = scaled[count].signum;
+            }
+            else {
+                term[count] = X[next];
+                coef[count] = X[next]->signum*k[next];
+            }
+            count++;
+        }
+        first = false;
+
+        for( size_t j = 0; j < count; j++ ) {
+            width = std::max(width, term[j]->digits.size());
+        }
+
+        // this may be among the terms: size it before taking any pointers
+        const Limb* limbs[LINEAR_TERMS];
+        size_t lens[LINEAR_TERMS];
+
+        for( size_t j = 0; j < count; j++ ) {
+            lens[j] = term[j]->digits.size();
+        }
+        digits.reserve(width + 2);
+        for( size_t j = 0; j < count; j++ ) {
+            limbs[j] = term[j]->digits.data();
+        }
+        digits.resize(width);
+
+        std::int64_t carry = 0;
+
+        for( size_t i = 0; i < width; i++ ) {
+            std::int64_t t = carry;             // |t| < 8*BASE^2 + 8*BASE
+
+            for( size_t j = 0; j < count; j++ ) {
+                if( i < lens[j] ) {
+                    t += coef[j]*limbs[j][i];
+                }
+            }
+
+            std::int64_t r = t % (std::int64_t)BASE;
+            if( r < 0 ) {
+                r += BASE;
+            }
+            digits[i] = (Limb)r;
+            carry = (t - r)/(std::int64_t)BASE;
+        }
+
+        int sign = 1;
+
+        // a negative carry means the total is carry*BASE^width + digits < 0:
+        // its magnitude is (-carry)*BASE^width - digits
+        if( carry < 0 ) {
+            size_t i = 0;
+
+            sign = -1;
+            carry = -carry;
+            while( i < width && digits[i]==0 ) {
+                i++;
+            }
+            if( i < width ) {
+                digits[i] = BASE - digits[i];
+                for( i++; i < width; i++ ) {
+                    digits[i] = BASE - 1 - digits[i];
+                }
+                carry--;
+            }
+        }
+
+        for( ; carry > 0; carry /= BASE ) {
+            digits.push_back((Limb)(carry % BASE));
+        }
+
+        normalizeLimbs(digits);
+        signum = digits.empty() ? 0 : sign;
+    }
+}
+
+// square()
+// Returns a BigInteger representing this*this, forming each cross product
+// only once.
+BigInteger BigInteger::square() const {
+    BigInteger P = BigInteger();
+
+    if( signum==0 ) {
+        return P;
+    }
+
+    P.digits.resize(2*digits.size());
+    sqrLimbs(P.digits.data(), digits.data(), digits.size());
+    normalizeLimbs(P.digits);
+    P.signum = 1;
+
+    return P;
+}
+
+// div()
+// Returns the quotient of this divided by N, truncated toward zero.
+// Pre: N is non-zero.
+BigInteger BigInteger::div(const BigInteger& N) const {
+    BigInteger Q, R;
+    divmod(N, Q, R);
+    return Q;
+}
+
+// div()
+// Returns the quotient of this divided by d, truncated toward zero.
+// Pre: d!=0
+BigInteger BigInteger::div(long d) const {
+    // error message
+    if( d==0 ) {
+        throw std::runtime_error("BigInteger: div(): division by zero");
+    }
+
+    unsigned long mag = (d < 0) ? 0UL - (unsigned long)d : (unsigned long)d;
+
+    // divisors of two or more limbs take the general path
+    if( mag >= BASE ) {
+        return div(BigInteger(d));
+    }
+
+    BigInteger Q;
+    divSmallLimbs(Q.digits, digits, (Limb)mag);
+    Q.signum = Q.digits.empty() ? 0 : signum*((d < 0) ? -1 : 1);
+
+    return Q;
+}
+
+// mod()
+// Returns the remainder of this divided by N, with the sign of this.
+// Pre: N is non-zero.
+BigInteger BigInteger::mod(const BigInteger& N) const {
+    BigInteger Q, R;
+    divmod(N, Q, R);
+    return R;
+}
+
+// mod()
+// Returns the remainder of this divided by d, with the sign of this.
+// Pre: d!=0
+long BigInteger::mod(long d) const {
+    // error message
+    if( d==0 ) {
+        throw std::runtime_error("BigInteger: mod(): division by zero");
+    }
+
+    unsigned long mag = (d < 0) ? 0UL - (unsigned long)d : (unsigned long)d;
+
+    // divisors of two or more limbs take the general path
+    if( mag >= BASE ) {
+        BigInteger R = mod(BigInteger(d));
+        long r = 0;
+
+        for( size_t i = R.digits.size(); i-- > 0; ) {
+            r = r*BASE + R.digits[i];           // |R| < |d|, so this fits
+        }
+        return R.signum*r;
+    }
+
+    // remainder of a single-limb division, computed without a quotient
+    DLimb rem = 0;
+    for( size_t i = digits.size(); i-- > 0; ) {
+        rem = (rem*BASE + digits[i]) % mag;
+    }
+
+    return signum*(long)rem;
+}
+
+// divmod()
+// Overwrites Q and R with div(N) and mod(N), computed together.
+// Pre: N is non-zero.
+void BigInteger::divmod(const BigInteger& N, BigInteger& Q, BigInteger& R) const {
+    // error message
+    if( N.signum==0 ) {
+        throw std::runtime_error("BigInteger: divmod(): division by zero");
+    }
+
+    LimbVector q, r;
+    divmodLimbs(q, r, digits, N.digits);
+
+    int qsign = q.empty() ? 0 : signum*N.signum;
+    int rsign = r.empty() ? 0 : signum;
+
+    Q.digits.swap(q);
+    Q.signum = qsign;
+    R.digits.swap(r);
+    R.signum = rsign;
+}
+
+
+// Exponentiation -------------------------------------------------------------
+
+// pow()
+// Returns B^e using sliding-window square-and-multiply. pow(B, 0) is 1.
+BigInteger pow(const BigInteger& B, unsigned long e) {
+    if( e==0 ) {
+        return BigInteger(1);
+    }
+
+    vector<unsigned char> bits;
+    for( ; e > 0; e >>= 1 ) {
+        bits.push_back(e & 1);
+    }
+
+    return windowPow(B, bits, [](const BigInteger& x, const BigInteger& y) { return x*y; });
+}
+
+// MontgomeryContext()
+// Constructor that precomputes everything modpow() needs for modulus M.
+// Pre: M > 0
+MontgomeryContext::MontgomeryContext(const BigInteger& M) : modulus(M) {
+    // error message
+    if( M.signum <= 0 ) {
+        throw std::invalid_argument("MontgomeryContext: Constructor: modulus must be positive");
+    }
+
+    const LimbVector& m = M.digits;
+    size_t k = m.size();
+
+    // Montgomery form needs gcd(M, BASE) = 1, i.e. M coprime to 10
+    montgomery = (m[0] % 2 != 0) && (m[0] % 5 != 0);
+
+    if( montgomery ) {
+        // minv = -M^(-1) mod BASE, from the extended Euclidean algorithm
+        std::int64_t r0 = BASE, r1 = m[0] % BASE, t0 = 0, t1 = 1;
+        while( r1 != 0 ) {
+            std::int64_t q = r0 / r1;
+            std::int64_t r2 = r0 - q*r1;
+            std::int64_t t2 = t0 - q*t1;
+            r0 = r1; r1 = r2;
+            t0 = t1; t1 = t2;
+        }
+        std::int64_t inv = ((t0 % (std::int64_t)BASE) + BASE) % BASE;
+        minv = (Limb)((BASE - inv) % BASE);
+
+        // R^2 mod M, with R = BASE^k
+        LimbVector power, q;
+        powerOfBase(power, 2*k);
+        divmodLimbs(q, r2, power, m);
+    }
+    else {
+        // fall back to Barrett reduction with a precomputed reciprocal
+        minv = 0;
+        reciprocalLimbs(reciprocal, m);
+    }
+}
+
+// reduce()
+// Overwrites T with T*R^(-1) mod M (Montgomery) or T mod M (Barrett).
+// Pre: T < M^2. Used by modpow().
+void MontgomeryContext::reduce(LimbVector& T) const {
+    if( montgomery ) {
+        montgomeryReduce(T, modulus.digits, minv);
+    }
+    else {
+        LimbVector q, r;
+        barrettLimbs(q, r, T, modulus.digits, reciprocal);
+        T.swap(r);
+    }
+}
+
+// modpow()
+// Returns B^E mod M, with the result in the range [0, M). Each call to this
+// overload builds a MontgomeryContext; reuse one across calls with the
+// same modulus via the overload that takes the context.
+// Pre: E >= 0, M > 0
+BigInteger modpow(const BigInteger& B, const BigInteger& E, const BigInteger& M) {
+    MontgomeryContext ctx(M);
+    return modpow(B, E, ctx);
+}
+
+// modpow()
+// Returns B^E mod M for the modulus M of ctx, with the result in the range
+// [0, M). Works in Montgomery form when M is coprime to 10 and with Barrett
+// reduction otherwise.
+// Pre: E >= 0
+BigInteger modpow(const BigInteger& B, const BigInteger& E, const MontgomeryContext& ctx) {
+    const LimbVector& m = ctx.modulus.digits;
+
+    // error message
+    if( E.signum < 0 ) {
+        throw std::invalid_argument("BigInteger: modpow(): negative exponent");
+    }
+
+    BigInteger result;
+
+    if( m.size()==1 && m[0]==1 ) {
+        return result;                          // everything is 0 mod 1
+    }
+    if( E.signum==0 ) {
+        return BigInteger(1);
+    }
+
+    // reduce the base into [0, M)
+    BigInteger x = B.mod(ctx.modulus);
+    if( x.signum < 0 ) {
+        x += ctx.modulus;
+    }
+    if( x.signum==0 ) {
+        return result;
+    }
+
+    LimbVector base = x.digits;
+
+    // enter Montgomery form: base*R mod M = REDC(base * R^2)
+    if( ctx.montgomery ) {
+        LimbVector t;
+        multLimbs(t, base, ctx.r2);
+        ctx.reduce(t);
+        base.swap(t);
+    }
+
+    auto mulmod = [&ctx](const LimbVector& a, const LimbVector& b) {
+        LimbVector t;
+        multLimbs(t, a, b);
+        ctx.reduce(t);
+        return t;
+    };
+
+    LimbVector r = windowPow(base, exponentBits(E.digits), mulmod);
+
+    // leave Montgomery form: REDC(r) = r*R^(-1)
+    if( ctx.montgomery ) {
+        ctx.reduce(r);
+    }
+
+    result.digits.swap(r);
+    result.signum = result.digits.empty() ? 0 : 1;
+
+    return result;
+}
+
+
+// Number theory --------------------------------------------------------------
+
+// gcdInPlace()
+// Overwrites this with gcd(this, N) and N with 0. Each round either applies
+// a whole run of Euclid steps at once, found by lehmerMatrix() from the
+// leading digits, or falls back to one full division when the leading
+// digits settle nothing. Once both values fit in a machine word, gcd() is
+// finished by binaryGcd() and xgcd() by word-sized Euclid. If S is non-null,
+// S[0] and S[1] go through the same steps as this and N.
+// Pre: this >= N >= 0
+void BigInteger::gcdInPlace(BigInteger& N, BigInteger* S) {
+    LimbVector& a = digits;
+    LimbVector& b = N.digits;
+    LimbVector x, y;
+
+    while( !b.empty() ) {
+        if( a.size() <= 2 ) {
+            std::uint64_t u = wordValue(a), v = wordValue(b);
+
+            if( S==nullptr ) {
+                setWordValue(a, binaryGcd(u, v));
+            }
+            else {
+                std::int64_t u0 = 1, v0 = 0, u1 = 0, v1 = 1;
+
+                while( v != 0 ) {
+                    std::int64_t q = (std::int64_t)(u / v);
+                    std::uint64_t r = u % v;
+                    std::int64_t u2 = u0 - q*u1;
+                    std::int64_t v2 = v0 - q*v1;
+
+                    u = v; v = r;
+                    u0 = u1; u1 = u2;
+                    v0 = v1; v1 = v2;
+                }
+                setWordValue(a, u);
+
+                BigInteger s0 = S[0]*(long)u0;
+                BigInteger s1 = S[0]*(long)u1;
+                s0.addmul(S[1], (long)v0);
+                s1.addmul(S[1], (long)v1);
+                S[0] = std::move(s0);
+                S[1] = std::move(s1);
+            }
+
+            b.clear();
+            break;
+        }
+
+        std::int64_t m[4];
+
+        if( lehmerMatrix(a, b, m) ) {
+            linearLimbs(x, a, m[0], b, m[1]);
+            linearLimbs(y, a, m[2], b, m[3]);
+            a.swap(x);
+            b.swap(y);
+
+            if( S != nullptr ) {
+                BigInteger s0 = S[0]*(long)m[0];
+                BigInteger s1 = S[0]*(long)m[2];
+                s0.addmul(S[1], (long)m[1]);
+                s1.addmul(S[1], (long)m[3]);
+                S[0] = std::move(s0);
+                S[1] = std::move(s1);
+            }
+        }
+        else {
+            BigInteger Q;
+
+            divmodLimbs(Q.digits, x, a, b);
+            a.swap(b);
+            b.swap(x);
+
+            if( S != nullptr ) {
+                Q.signum = 1;                   // a >= b, so the quotient is positive
+                BigInteger s1 = S[0] - Q*S[1];
+                S[0] = std::move(S[1]);
+                S[1] = std::move(s1);
+            }
+        }
+    }
+
+    signum = a.empty() ? 0 : 1;
+    N.signum = 0;
+}
+
+// gcd()
+// Returns the greatest common divisor of A and B, which is never negative.
+// gcd(0, 0) is 0.
+BigInteger gcd(const BigInteger& A, const BigInteger& B) {
+    BigInteger a = A, b = B;
+
+    a.signum *= a.signum;
+    b.signum *= b.signum;
+    if( compareLimbs(a.digits, b.digits) < 0 ) {
+        std::swap(a, b);
+    }
+
+    a.gcdInPlace(b, nullptr);
+
+    return a;
+}
+
+// xgcd()
+// Returns g = gcd(A, B) and overwrites S and T with the cofactors
+// A*S + B*T = g that Euclid's algorithm produces. Only the cofactor of A is
+// carried through the reduction; T is recovered from it by one exact
+// division at the end.
+BigInteger xgcd(const BigInteger& A, const BigInteger& B, BigInteger& S, BigInteger& T) {
+    BigInteger a = A, b = B;
+    BigInteger C[2] = { BigInteger(1), BigInteger() };
+
+    a.signum *= a.signum;
+    b.signum *= b.signum;
+    if( compareLimbs(a.digits, b.digits) < 0 ) {
+        std::swap(a, b);
+        std::swap(C[0], C[1]);
+    }
+
+    a.gcdInPlace(b, C);
+
+    // S and T may alias A and B, so both are written only at the end
+    BigInteger s, t;
+    if( a.signum != 0 ) {
+        s = C[0];
+        if( A.signum < 0 ) {
+            s.negate();
+        }
+        if( B.signum != 0 ) {
+            t = (a - A*s).div(B);
+        }
+    }
+
+    S = std::move(s);
+    T = std::move(t);
+
+    return a;
+}
+
+// modinv()
+// Returns the inverse of A modulo M, in the range [0, M). Throws
+// std::invalid_argument if M is not positive or A has no inverse.
+// Pre: M > 0, gcd(A, M) = 1
+BigInteger modinv(const BigInteger& A, const BigInteger& M) {
+    // error message
+    if( M.signum <= 0 ) {
+        throw std::invalid_argument("BigInteger: modinv(): modulus must be positive");
+    }
+
+    BigInteger a = A.mod(M);
+    if( a.signum < 0 ) {
+        a += M;
+    }
+
+    BigInteger m = M;
+    BigInteger C[2] = { BigInteger(), BigInteger(1) };
+
+    m.gcdInPlace(a, C);
+
+    // error message
+    if( m.digits.size() != 1 || m.digits[0] != 1 ) {
+        throw std::invalid_argument("BigInteger: modinv(): not invertible");
+    }
+
+    if( C[0].signum < 0 ) {
+        C[0] += M;
+    }
+
+    return C[0];
+}
+
+
+// rootMagnitude()
+// Returns the floor of the k-th root of this. Large values take the root of
+// their leading limbs recursively, keeping about half the limbs of the
+// result; smaller ones start from a long double estimate. Either seed lies
+// above the root, and Newton's step x -> ((k-1)x + N/x^(k-1))/k never goes
+// below it, so the first x with x^k <= N is the answer. From a seed good to
+// half the digits that is nearly always the first step, and the recursion
+// halves the length each time: the total cost is a small multiple of one
+// full-length division and power.
+// Pre: this > 0, k >= 2
+BigInteger BigInteger::rootMagnitude(unsigned long k) const {
+    size_t n = digits.size();
+    size_t j = (n/k)/2;                 // limbs dropped from the root below
+    BigInteger x;
+
+    if( j >= 2 ) {
+        j--;
+
+        BigInteger top;
+        top.digits.assign(digits.begin() + k*j, digits.end());
+        top.signum = 1;
+
+        x = top.rootMagnitude(k).add(1);
+        shiftLimbs(x.digits, j);
     }
     else {
-        signum = 0;                             // zero
+        long double lv = logMagnitude(digits);
+
+        // this < 2^k: the root is 1
+        if( lv < k*std::log(2.0L) - 1e-9L ) {
+            return BigInteger(1);
+        }
+
+        long double r = std::ceil(std::exp(lv/k)*(1 + 1e-9L)) + 1;
+        for( ; r >= 1; r = std::floor(r/BASE) ) {
+            x.digits.push_back((Limb)std::fmod(r, (long double)BASE));
+        }
+        x.signum = 1;
     }
-    
-    // get digits from x and insert them into the List 'digits'
-    while (x > 0) {
-        digits.insertBefore(x % BASE);          // extract the last digit of x in base BASE
-        x /= BASE;                              // move to next digit
+
+    // Newton's step from above decreases until it reaches the root
+    for( ;; ) {
+        x = x.mult((long)(k - 1)).add(div(pow(x, k - 1))).div((long)k);
+
+        if( pow(x, k).compare(*this) <= 0 ) {
+            return x;
+        }
     }
 }
 
-// BigInteger()
-// Constructor that creates a new BigInteger from the string s.
-// Pre: s is a non-empty string consisting of (at least one) base 10 digit
-// {0,1,2,3,4,5,6,7,8,9}, and an optional sign {+,-} prefix.
-BigInteger::BigInteger(std::string s) {
+// isqrt()
+// Returns the floor of the square root of this.
+// Pre: this >= 0
+BigInteger BigInteger::isqrt() const {
     // error message
-    if( s.length()==0 ) {
-        throw std::invalid_argument("BigInteger: Constructor: empty string");
+    if( signum < 0 ) {
+        throw std::invalid_argument("BigInteger: isqrt(): negative argument");
     }
 
-    // determine the sign of the BigInteger
-    if( s[0]=='+' || s[0]=='-' ) {
-        signum = 1;                             // default to positive sign
-        
-        if( s[0]=='-' ) {
-            signum = -1;                        // set to negative if '-' is at s[0]
-        }
+    return (signum==0) ? BigInteger() : rootMagnitude(2);
+}
 
-        s = s.substr(1, s.length() - 1);        // remove the sign prefix from the string
+// iroot()
+// Returns the k-th root of this, truncated toward zero.
+// Pre: k >= 1, and k is odd if this < 0
+BigInteger BigInteger::iroot(unsigned long k) const {
+    // error message
+    if( k==0 ) {
+        throw std::invalid_argument("BigInteger: iroot(): zeroth root");
     }
-    else {
-        signum = 1;                             // default to positive sign if no sign prefix
+    if( signum < 0 && k % 2==0 ) {
+        throw std::invalid_argument("BigInteger: iroot(): even root of a negative number");
     }
 
-    // check that all characters in the string are numeric
-    for (long unsigned int i = 0; i < s.length();) {
-        // error message if not
-        if( !std::isdigit(s[i]) ) {
-            throw std::invalid_argument("BigInteger: Constructor: non-numeric string");
-        }
-        i++;
+    if( signum==0 || k==1 ) {
+        return *this;
     }
 
-    bool my_flag = false;
+    BigInteger a = *this;
+    a.signum = 1;
 
-    // extract digits from the string in groups of POWER
-    // insert them into the List 'digits'
-    for (int i = s.length() - POWER; ; i -= POWER) {
+    BigInteger R = a.rootMagnitude(k);
+    R.signum = signum;
 
-        // if i is less than 0, insert the last group of digits
-        if( i < 0 ) {
-            digits.insertAfter(stol(s.substr(0, i + POWER)));
-            my_flag = true;                     // set to break out of loop
-        }
+    return R;
+}
 
-        // if i is 0 or greater than 0, insert the current group of digits
-        else if( i==0 || i > 0 ) {
-            digits.insertAfter(stol(s.substr(i, POWER)));
-            
-            if( i==0 ) {
-                my_flag = true;                 // set to break out of loop
-            }
-        }
+// isPerfectSquare()
+// Returns true if and only if this is the square of an integer. Squares
+// mod 512 are read off the low limb (512 divides BASE), and squares mod 63,
+// 65 and 11 from one pass over the limbs; together these reject all but
+// about 1 in 700 non-squares before any root is taken.
+bool BigInteger::isPerfectSquare() const {
+    static const SquareResidues squares;
 
-        // break once the digits are inserted
-        if( my_flag ) {
-            break;
-        }
+    if( signum <= 0 ) {
+        return signum==0;
     }
-}
-
-// BigInteger()
-// Constructor that creates a copy of N.
-BigInteger::BigInteger(const BigInteger& N) {
-    digits = N.digits;
-    signum = N.signum;
-}
 
+    if( !squares.mod512[digits[0] % 512] ) {
+        return false;
+    }
 
-// Access functions -----------------------------------------------------------
+    long r = mod(63L*65*11);
+    if( !squares.mod63[r % 63] || !squares.mod65[r % 65] || !squares.mod11[r % 11] ) {
+        return false;
+    }
 
-// sign()
-// Returns -1, 1 or 0 according to whether this BigInteger is positive, 
-// negative or 0, respectively.
-int BigInteger::sign() const {
-    return signum;
+    return rootMagnitude(2).square()==*this;
 }
 
-// compare()
-// Returns -1, 1 or 0 according to whether this BigInteger is less than N,
-// greater than N or equal to N, respectively.
-int BigInteger::compare(const BigInteger& N) const {
-    // compare signs
-    if( signum!=N.signum ) {
-        // return -1 if this length is less, 1 if greater
-        return (signum < N.signum) ? -1 : 1;
+// isPerfectPower()
+// Returns true if and only if this is m^k for some integers m and k >= 2.
+// Only prime k need to be tried, up to the bit length of this. Where the
+// root would fit in 32 bits, its long double estimate must land on an
+// integer. The smaller k, with larger roots, are first screened with the
+// smallest primes p = 1 (mod k): only 1/k of the units mod p are k-th
+// powers, so a non-power survives each such p with chance about 1/k, and
+// enough p are used to bring that below 2^-16 before the exact root is
+// taken. The residues for every p come from one call to residuesMod().
+bool BigInteger::isPerfectPower() const {
+    if( signum==0 || (digits.size()==1 && digits[0]==1) ) {
+        return true;
     }
-    
-    // if both have the same sign
-    else {
-        // negative numbers
-        if( signum==-1 ) {
-            // compare lengths in reverse order
-            if( digits.length() != N.digits.length() ) {
-                // return 1 if this length is less, -1 if greater
-                return (digits.length() < N.digits.length()) ? 1 : -1;
-            }
+
+    // a negative value is a power only with an odd exponent
+    if( signum > 0 && isPerfectSquare() ) {
+        return true;
+    }
+
+    BigInteger a = *this;
+    a.signum = 1;
+
+    long double lv = logMagnitude(digits);
+    unsigned long kmax = (unsigned long)(lv/std::log(2.0L)) + 1;
+    unsigned long kbig = (unsigned long)(lv/std::log(4294967296.0L));
+
+    // the exponents, and the screening primes for k <= kbig, which are
+    // nearly always below 64*kbig, come from one sieve
+    size_t limit = std::max((size_t)kmax, (size_t)64*kbig) + 1;
+    vector<bool> prime = primeSieve(limit);
+
+    vector<long> P;                     // screening primes for each k <= kbig
+    vector<size_t> first;               // index in P of each k's first prime
+    for( unsigned long k = 3; k <= kbig; k += 2 ) {
+        if( !prime[k] ) {
+            continue;
         }
 
-        // positive numbers
-        else if( signum==1 ) {
-            // compare lengths
-            if( digits.length() != N.digits.length() ) {
-                // return 1 if this length is greater, -1 if less
-                return (digits.length() > N.digits.length()) ? 1 : -1;
+        first.push_back(P.size());
+
+        std::uint64_t odds = 1;
+        for( std::uint64_t p = 2*k + 1; p < BASE && odds < 65536; p += 2*k ) {
+            if( (p < limit) ? prime[p] : isPrimeWord(p) ) {
+                P.push_back((long)p);
+                odds *= k;
             }
         }
+    }
+    first.push_back(P.size());
 
-        // check for equality or non-equality based on digit values
-        if( digits==N.digits || (digits.length()==0 && N.digits.length()==0) ) {
-            return 0;
+    vector<long> R(P.size());
+    if( !P.empty() ) {
+        residuesMod(a, P, 0, P.size(), R);
+    }
+
+    size_t screened = 0;                // k <= kbig tried so far
+    for( unsigned long k = 3; k <= kmax; k += 2 ) {
+        if( !prime[k] ) {
+            continue;
         }
-        
-        // compare individual digits
-        List A  = digits;
-        List B = N.digits;
 
-        A.moveFront();
-        B.moveFront();
+        // the root is below 2^32, where r is good to about 1e-7, so an
+        // exact check on every r within 1e-6 of an integer is rare
+        if( k > kbig ) {
+            long double r = std::exp(lv/k);
+            long double m = std::round(r);
 
-        while (true) {
-            // if reached the end of A
-            if( A.position()==A.length() ) {
-                // if also reached the end of B, both are equal
-                if( B.position()==B.length() ) {
-                    return 0;
-                }
-                // else, A is shorter
-                else {
-                    return -1;
-                }
-            }
-            
-            // if reached the end of B, B is shorter
-            else if( B.position()==B.length() ) {
-                return 1;
+            if( m >= 2 && std::fabs(r - m) < 1e-6L && pow(BigInteger((long)m), k)==a ) {
+                return true;
             }
+            continue;
+        }
 
-            // A's current digit is greater
-            else if( A.peekNext() > B.peekNext() ) {
-                return 1;
-            }
+        bool may = true;
+        for( size_t i = first[screened]; i < first[screened + 1] && may; i++ ) {
+            std::uint64_t p = P[i];
 
-            // B's current digit is greater
-            else if( A.peekNext() < B.peekNext() ) {
-                return -1;
-            } 
-            else {
-                A.moveNext();
-                B.moveNext();
-            }
+            may = (R[i]==0 || powModWord(R[i], (p - 1)/k, p)==1);
+        }
+        screened++;
+
+        if( may && pow(a.rootMagnitude(k), k)==a ) {
+            return true;
         }
     }
 
-    return 0;
+    return false;
 }
 
 
-// Manipulation procedures -------------------------------------------------
+// Tuning functions -----------------------------------------------------------
 
-// makeZero()
-// Re-sets this BigInteger to the zero state.
-void BigInteger::makeZero() {
-    signum = 0;
-    digits.clear();
+// setMultThresholds()
+// Sets the operand sizes, in limbs, at which mult() switches from the
+// schoolbook basecase to Karatsuba and from Karatsuba to Toom-3.
+// Pre: 2 <= karatsuba <= toom3
+void BigInteger::setMultThresholds(int karatsuba, int toom3) {
+    if( karatsuba < 2 || toom3 < karatsuba ) {
+        throw std::invalid_argument("BigInteger: setMultThresholds(): invalid thresholds");
+    }
+
+    karatsuba_threshold = karatsuba;
+    toom3_threshold = toom3;
 }
 
-// negate()
-// If this BigInteger is zero, does nothing, otherwise reverses the sign of 
-// this BigInteger positive <--> negative. 
-void BigInteger::negate() {
-    if( signum!=0 ) {
-        signum *= -1;
+// setNTTThreshold()
+// Sets the operand size, in limbs, at which mult() switches from Toom-3 to
+// the three-prime number-theoretic transform.
+// Pre: ntt >= 2
+void BigInteger::setNTTThreshold(int ntt) {
+    if( ntt < 2 ) {
+        throw std::invalid_argument("BigInteger: setNTTThreshold(): invalid threshold");
     }
-}
 
+    ntt_threshold = ntt;
+}
 
-// Helper functions implementation -----------------------------------------
+// setMultThreads()
+// Sets the number of threads mult() may spread one product over; 0 means
+// one per hardware thread.
+// Pre: threads >= 0
+void BigInteger::setMultThreads(int threads) {
+    if( threads < 0 ) {
+        throw std::invalid_argument("BigInteger: setMultThreads(): invalid thread count");
+    }
 
-// negateList()
-// Changes the sign of each integer in List L. Used by sub().
-void negateList(List& L) {
-    L.moveFront();
+    mult_threads = threads;
+}
 
-    // iterate through each element
-    while (L.position() < L.length()) {
-        L.setAfter(-1 * L.peekNext());          // set the current element to its negation
-        L.moveNext();
+// setParallelThreshold()
+// Sets the shorter-operand size, in limbs, below which a product always
+// runs serially.
+// Pre: limbs >= 1
+void BigInteger::setParallelThreshold(int limbs) {
+    if( limbs < 1 ) {
+        throw std::invalid_argument("BigInteger: setParallelThreshold(): invalid threshold");
     }
+
+    parallel_threshold = limbs;
 }
 
-// sumList()
-// Overwrites the state of S with A + sgn*B (considered as vectors).
-// Used by both sum() and sub().
-void sumList(List& S, List A, List B, int sgn) {
-    // clear S
-    S.clear();
+// setScratchLimit()
+// Sets how many bytes of free limb buffers the built-in ScratchArenas of all
+// threads keep for reuse between them. 0 turns the cache off.
+void BigInteger::setScratchLimit(std::size_t bytes) {
+    scratch_limit = bytes;
+}
 
-    // multiply List B by the scalar multiplier sgn
-    scalarMultList(B, sgn);
+// Other Functions ---------------------------------------------------------
 
-    A.moveBack();
-    B.moveBack();
-    
-    // iterate through A and B
-    while (true) {
-        // if both Lists A and B have more elements
-        if( A.position()!=0 && B.position()!=0 ) {
-            int res = A.peekPrev() + B.peekPrev();
-            S.insertAfter(res);                 // insert sum of corresponding elements into S
+// to_string()
+// Returns a string representation of this BigInteger consisting of its
+// base 10 digits. If this BigInteger is negative, the returned string
+// will begin with a negative sign '-'. If this BigInteger is zero, the
+// returned string will consist of the character '0' only.
+std::string BigInteger::to_string() const {
+    // if the BigInteger is 0
+    if( signum==0 ) {
+        return "0";
+    }
 
-            B.movePrev();
-            A.movePrev();
-        }
+    // the exact length is known up front, so the string is allocated once
+    int top_len = topLimbLength(digits.back());
+    size_t neg = (signum==-1) ? 1 : 0;
+    std::string output(neg + top_len + POWER*(digits.size() - 1), '0');
 
-        // if only B has more elements
-        else if( B.position()!=0 ) {
-            S.insertAfter(B.peekPrev());        // insert remaining B elements into S
-            B.movePrev();
-        } 
+    // if the BigInteger is negative, add a negative sign
+    if( neg ) {
+        output[0] = '-';
+    }
 
-        // if only A has more elements
-        else if( A.position()!=0 ) {
-            S.insertAfter(A.peekPrev());        // insert remaining A elements into S
-            A.movePrev();
-        } 
+    writeDecimal(&output[neg], digits.back(), top_len);
 
-        // if no more elements in either list, break
-        else {
-            break;
-        }
+    // every other limb is padded to POWER decimal digits
+    char* out = &output[neg + top_len];
+    for( size_t i = digits.size() - 1; i-- > 0; out += POWER ) {
+        writeDecimal(out, digits[i], POWER);
     }
+
+    return output;
 }
 
-// normalizeList()
-// Performs carries from right to left (least to most significant
-// digits), then returns the sign of the resulting integer. Used
-// by add(), sub() and mult().
-int normalizeList(List &L) {
-    long carry = 0;
-    L.moveBack();
 
-    // iterate from right to left
-    for (; L.position() > 0 || carry != 0; L.movePrev()) {
-        // if reached the leftmost end of L
-        if(L.position()==0 ) {
-            L.insertAfter(carry);               // insert any remaining carry as a new element
-            carry = 0;                          // reset carry to 0
-            break;
-        }
+// Serialization ----------------------------------------------------------
 
-        long sum = L.peekPrev() + carry;        // sum of current element and the carry
-        carry = sum / BASE;                     // new carry
-        L.setBefore(sum % BASE);                // set current element to the remainder after division by BASE
+// serializedSize()
+// Returns the number of bytes serialize() writes for this BigInteger.
+std::size_t BigInteger::serializedSize() const {
+    return RECORD_HEADER + 4*digits.size();
+}
 
-        // if the current element is negative and not leftmost
-        if( L.peekPrev() < 0 && L.position()!=1 ) {
-            carry -= 1;                         // adjust the carry
-            L.setBefore(L.peekPrev() + BASE);   // add BASE to the current element to make it positive
-        }
-    }
+// serialize()
+// Writes the binary record of this BigInteger to out. On little-endian
+// hosts the limbs go out straight from memory.
+void BigInteger::serialize(std::ostream& out) const {
+    unsigned char header[RECORD_HEADER];
 
-    L.moveFront();
-    
-    // remove leading zeros from the list
-    while (L.peekNext() == 0 && L.length() > 2) {
-        L.eraseAfter();
-    }
-    
-    L.moveFront();
+    writeRecordHeader(header, signum, digits.size());
+    out.write((const char*)header, RECORD_HEADER);
 
-    // determine the sign of the resulting integer
-    if( L.peekNext() > 0 ) {
-        return 1;                               // positive
+    if( hostIsLittleEndian() ) {
+        out.write((const char*)digits.data(), 4*digits.size());
+        return;
     }
-    else if( L.peekNext() < 0 ) {
-        negateList(L);                          // change the sign to make it positive
-        carry = 0;                              // reset carry to 0
 
-        // iterate from right to left
-        for (int pos = L.position(); pos > 0; L.movePrev(), pos--) {
-            L.setBefore(L.peekPrev() + carry);  // add any remaining carry to the current element
-            
-            // if the current element is negative, adjust the carry and add BASE to make positive
-            if( L.peekPrev() < 0 ) {
-                carry = -1;
-                L.setBefore(L.peekPrev() + BASE);
-            }
-            else {
-                carry = 0;
-            }
-        }
+    unsigned char chunk[4096];
+    for( size_t i = 0; i < digits.size(); ) {
+        size_t len = std::min(digits.size() - i, sizeof(chunk)/4);
 
-        return -1;
-    }
-    else {
-        return 0;
+        for( size_t j = 0; j < len; j++ ) {
+            storeLE(chunk + 4*j, digits[i + j], 4);
+        }
+        out.write((const char*)chunk, 4*len);
+        i += len;
     }
 }
 
-// shiftList()
-// Prepends p zero digits to L, multiplying L by base^p. Used by mult().
-void shiftList(List& L, int p) {
-    int i = 0;
+// serialize()
+// Writes the binary record of this BigInteger to the size bytes at buffer
+// and returns the number of bytes written.
+// Pre: size >= serializedSize()
+std::size_t BigInteger::serialize(void* buffer, std::size_t size) const {
+    unsigned char* out = (unsigned char*)buffer;
 
-    while (i < p) {
-        L.insertAfter(0);
-        i++;
+    // error message
+    if( size < serializedSize() ) {
+        throw std::invalid_argument("BigInteger: serialize(): buffer too small");
     }
-}
 
-// scalarMultList()
-// Multiplies L (considered as a vector) by m. Used by mult().
-void scalarMultList(List& L, ListElement m) {
-    L.moveFront();
+    writeRecordHeader(out, signum, digits.size());
+    out += RECORD_HEADER;
 
-    while (L.position() < L.length()) {
-        L.setAfter(L.peekNext() * m);           // set the current element to its product with m
-        L.moveNext();
+    if( hostIsLittleEndian() ) {
+        std::copy((const unsigned char*)digits.data(), (const unsigned char*)(digits.data() + digits.size()), out);
     }
+    else {
+        for( size_t i = 0; i < digits.size(); i++ ) {
+            storeLE(out + 4*i, digits[i], 4);
+        }
+    }
+
+    return serializedSize();
 }
 
+// deserialize()
+// Overwrites this BigInteger with the binary record read from in. The limbs
+// are read in bounded chunks, so a corrupt limb count cannot force a huge
+// allocation before the input runs out.
+void BigInteger::deserialize(std::istream& in) {
+    unsigned char header[RECORD_HEADER];
+    int sign;
 
-// BigInteger Arithmetic operations -------------------------------------------
+    if( !in.read((char*)header, RECORD_HEADER) ) {
+        throw std::runtime_error("BigInteger: deserialize(): unexpected end of input");
+    }
 
-// add()
-// Returns a BigInteger representing the sum of this and N.
-BigInteger BigInteger::add(const BigInteger& N) const {
-    List A = N.digits;                          // copy of digits of BigInteger N
-    List B = digits;                            // copy of the digits of this BigInteger
+    size_t count = readRecordHeader(header, sign, "deserialize()");
+    LimbVector L;
+    vector<unsigned char> chunk;
 
-    BigInteger S;                               // resulting sum
-    
-    // cases based on the signs of this BigInteger and N
-    if( N.signum==-1 ) {
-        if( signum==1 ) {
-            sumList(S.digits, B, A, -1);        // subtract A from B and store in S
-        }
-        else if( signum==-1 ) {
-            scalarMultList(B, -1);              // multiply B by -1 to make it positive
-            sumList(S.digits, B, A, -1);        // subtract A from B and store in S
-        }
-        else if( signum==0 ) {
-            S.digits = A;                       // copy the digits of N to S
-            S.signum = N.signum;                // set the sign of S to be the sign of N
+    for( size_t done = 0; done < count; ) {
+        size_t len = std::min(count - done, (size_t)1 << 16);
 
-            return S;
-        }
-    }
-    else if( N.signum==1 ) {
-        if( signum==-1 ) {
-            sumList(S.digits, A, B, -1);        // subtract B from A and store in S
+        chunk.resize(4*len);
+        if( !in.read((char*)chunk.data(), chunk.size()) ) {
+            throw std::runtime_error("BigInteger: deserialize(): unexpected end of input");
         }
-        else if( signum==1 ) {
-            sumList(S.digits, B, A, 1);         // add A and B and store in  S
-        }
-        else if( signum==0 ) {
-            S.digits = A;                       // copy the digits of N to S
-            S.signum = N.signum;                // set the sign of S to be the sign of N
 
-            return S;
-        }
+        LimbVector part;
+        readRecordLimbs(part, chunk.data(), len, "deserialize()");
+        L.insert(L.end(), part.begin(), part.end());
+        done += len;
     }
-    else if( N.signum==0 ) {
-        S.digits = digits;                      // copy the digits of this BigInteger to S
-        S.signum = signum;                      // set the sign of S to be the sign of this BigInteger
 
-        return S;
+    if( count > 0 && L.back()==0 ) {
+        throw std::invalid_argument("BigInteger: deserialize(): leading zero limb");
     }
 
-    S.signum = normalizeList(S.digits);         // normalize the result and set its sign
-
-    return S;
+    digits.swap(L);
+    signum = sign;
 }
 
-// sub()
-// Returns a BigInteger representing the difference of this and N.
-BigInteger BigInteger::sub(const BigInteger& N) const {
-    List A = N.digits;                          // copy of digits of BigInteger N
-    List B = digits;                            // copy of the digits of this BigInteger
+// deserialize()
+// Overwrites this BigInteger with the binary record at the front of the
+// size bytes at buffer and returns the record's length in bytes.
+std::size_t BigInteger::deserialize(const void* buffer, std::size_t size) {
+    const unsigned char* in = (const unsigned char*)buffer;
+    int sign;
 
-    BigInteger D;                               // resulting difference
+    if( size < RECORD_HEADER ) {
+        throw std::runtime_error("BigInteger: deserialize(): unexpected end of input");
+    }
 
-    // cases based on the sign of this BigInteger
-    if( signum==1 ) {
-        // cases based on the sign of N
-        if( N.signum==1 ) {
-            sumList(D.digits, B, A, -1);        // subtract A from B and store in D
-        }
-        else {
-            sumList(D.digits, B, A, 1);         // add A and B and store in D
-        }
+    size_t count = readRecordHeader(in, sign, "deserialize()");
+    if( size - RECORD_HEADER < 4*count ) {
+        throw std::runtime_error("BigInteger: deserialize(): unexpected end of input");
     }
-    else {
-        // cases based on the sign of N
-        if( N.signum==1 ) {
-            scalarMultList(B, -1);              // multiply B by -1 to make it positive
-            sumList(D.digits, B, A, -1);        // subtract A from B and store in D
-        }
-        else {
-            scalarMultList(B, -1);              // multiply B by -1 to make it positive
-            sumList(D.digits, B, A, 1);         // add A and B and store in D
-        }
+
+    LimbVector L;
+    readRecordLimbs(L, in + RECORD_HEADER, count, "deserialize()");
+
+    if( count > 0 && L.back()==0 ) {
+        throw std::invalid_argument("BigInteger: deserialize(): leading zero limb");
     }
 
-    D.signum = normalizeList(D.digits);         // normalize the result and set its sign
+    digits.swap(L);
+    signum = sign;
 
-    return D;
+    return RECORD_HEADER + 4*count;
 }
 
-// mult()
-// Returns a BigInteger representing the product of this and N. 
-BigInteger BigInteger::mult(const BigInteger& N) const {
-    List curr_long = digits;                    // a list with the digits of this BigInteger
-    List long_N = N.digits;                     // a list with the digits of N
-    List product = List();                      // a list to store intermediate products
-    BigInteger P = BigInteger();                // resulting product
 
-    long_N.moveBack();
+// BigIntegerView ---------------------------------------------------------
 
-    // iterate through the digits of N
-    while (long_N.position() > 0) {
-        // multiply curr_long by the last digit of N, then add the intermediate product to the running total
-        scalarMultList(curr_long, long_N.peekPrev());
-        sumList(product, product, curr_long, 1);
-        normalizeList(product);
+// BigIntegerView()
+// Creates a view of the record at the front of the size bytes at buffer.
+BigIntegerView::BigIntegerView(const void* buffer, std::size_t size) {
+    const unsigned char* in = (const unsigned char*)buffer;
 
-        product.moveBack();
+    if( size < RECORD_HEADER ) {
+        throw std::runtime_error("BigIntegerView: Constructor: unexpected end of input");
+    }
 
-        // add the shifted product to the final result
-        shiftList(product, N.digits.length() - long_N.position());
-        sumList(P.digits, P.digits, product, 1);
-        normalizeList(P.digits);
+    count = readRecordHeader(in, signum, "BigIntegerView()");
+    if( size - RECORD_HEADER < 4*count ) {
+        throw std::runtime_error("BigIntegerView: Constructor: unexpected end of input");
+    }
 
-        product.clear();                        // clear for next iteration
+    // the limbs are used in place, so they must already be native Limbs
+    if( !hostIsLittleEndian() ) {
+        throw std::runtime_error("BigIntegerView: Constructor: records cannot be viewed in place on a big-endian host");
+    }
+    if( (std::uintptr_t)(in + RECORD_HEADER) % alignof(Limb) != 0 ) {
+        throw std::invalid_argument("BigIntegerView: Constructor: record is not 4-byte aligned");
+    }
 
-        curr_long = digits;                     // reset curr_long
+    limbs = (const Limb*)(in + RECORD_HEADER);
 
-        long_N.movePrev();
+    if( count > 0 && (limbs[count - 1]==0 || limbs[count - 1] >= BASE) ) {
+        throw std::invalid_argument("BigIntegerView: Constructor: malformed top limb");
     }
+}
 
-    P.signum = signum * N.signum;               // set the sign of the resulting product
+// sign()
+// Returns -1, 1 or 0 according to whether the viewed value is negative,
+// positive or 0.
+int BigIntegerView::sign() const {
+    return signum;
+}
 
-    return P;
+// size()
+// Returns the number of limbs in the viewed value.
+std::size_t BigIntegerView::size() const {
+    return count;
 }
 
-// Other Functions ---------------------------------------------------------
+// data()
+// Returns the viewed limbs, least significant first.
+const Limb* BigIntegerView::data() const {
+    return limbs;
+}
 
-// to_string()
-// Returns a string representation of this BigInteger consisting of its
-// base 10 digits. If this BigInteger is negative, the returned string 
-// will begin with a negative sign '-'. If this BigInteger is zero, the
-// returned string will consist of the character '0' only.
-std::string BigInteger::to_string() {
-    // if the BigInteger is 0
-    if( signum==0 ) {
-        return "0";
+// recordSize()
+// Returns the length of the viewed record in bytes.
+std::size_t BigIntegerView::recordSize() const {
+    return RECORD_HEADER + 4*count;
+}
+
+// compare()
+// Returns -1, 1 or 0 according to whether the viewed value is less than N,
+// greater than N or equal to N, respectively.
+int BigIntegerView::compare(const BigInteger& N) const {
+    if( signum!=N.signum ) {
+        return (signum < N.signum) ? -1 : 1;
     }
 
-    std::string output = "";
+    int cmp = compareLimbs(limbs, count, N.digits.data(), N.digits.size());
 
-    // if the BigInteger is negative, add a negative sign
-    if( signum==-1 ) {
-        output += "-";
-    }
+    return (signum==-1) ? -cmp : cmp;
+}
 
-    // iterate through the digits
-    for (digits.moveFront(); digits.position() < digits.length(); digits.moveNext()) {
-        // get the current digit value and convert to string
-        int value = digits.peekNext();
-        std::string value_output = std::to_string(std::abs(value));
+// hash()
+// Returns the same hash as N.hash() for a BigInteger N of equal value.
+std::size_t BigIntegerView::hash() const {
+    return hashLimbs(signum, limbs, count);
+}
 
-        // add the digit to the output string with leading zeros if necessary
-        if( digits.position()==0 && value!=0 ) {
-            output += value_output;             // add the first non-zero digit without leading zeros
-        }
+// toBigInteger()
+// Returns a BigInteger holding a copy of the viewed value.
+BigInteger BigIntegerView::toBigInteger() const {
+    BigInteger N;
 
-        // else add leading zeros if necessary
-        else {
-            int add_zeros = POWER - value_output.length();
-            output += std::string(add_zeros, '0') + value_output;
-        }
-    }
+    readRecordLimbs(N.digits, (const unsigned char*)limbs, count, "toBigInteger()");
+    N.signum = signum;
 
-    if( output[0]=='-' ) {
-        // remove leading zeros after the negative sign
-        while (output[1] == '0') {
-            output.erase(1, 1);
-        }
+    return N;
+}
+
+
+// Overriden Operators --------------------------------------------------------
+
+// operator=()
+// Overwrites the state of this BigInteger with state of N.
+BigInteger& BigInteger::operator=( const BigInteger& N ) {
+    if( this!=&N ) {
+        signum = N.signum;
+        digits = N.digits;
     }
 
-    return output;
+    return *this;
 }
 
+// operator=()
+// Overwrites the state of this BigInteger with state of N, taking over its
+// limbs without copying them. N is left in the zero state.
+BigInteger& BigInteger::operator=( BigInteger&& N ) noexcept {
+    if( this!=&N ) {
+        signum = N.signum;
+        digits.swap(N.digits);
+        N.makeZero();                           // our old limbs are released with N
+    }
 
-// Overriden Operators --------------------------------------------------------
+    return *this;
+}
 
 // operator<<()
 // Inserts string representation of N into stream.
-std::ostream& operator<<(std::ostream& stream, BigInteger N) {
-    return stream << N.BigInteger::to_string();
+std::ostream& operator<<(std::ostream& stream, const BigInteger& N) {
+    // if the BigInteger is 0
+    if( N.signum==0 ) {
+        return stream << '0';
+    }
+
+    // limbs are formatted into a small buffer that is flushed as it fills,
+    // so no string the size of N is ever built
+    char buffer[4096];
+    size_t used = 0;
+
+    if( N.signum==-1 ) {
+        buffer[used++] = '-';
+    }
+
+    int top_len = topLimbLength(N.digits.back());
+    writeDecimal(buffer + used, N.digits.back(), top_len);
+    used += top_len;
+
+    for( size_t i = N.digits.size() - 1; i-- > 0; ) {
+        if( used + POWER > sizeof(buffer) ) {
+            stream.write(buffer, used);
+            used = 0;
+        }
+
+        writeDecimal(buffer + used, N.digits[i], POWER);
+        used += POWER;
+    }
+
+    return stream.write(buffer, used);
 }
 
 // operator==()
 // Returns true if and only if A equals B.
 bool operator==(const BigInteger& A, const BigInteger& B) {
-    if (A.compare(B) == 0) {
-        return true;
+    // equal values have equal signs and lengths; the limbs are then
+    // compared in one flat pass
+    if( A.signum!=B.signum || A.digits.size()!=B.digits.size() ) {
+        return false;
     }
-    return false;
+    return std::equal(A.digits.begin(), A.digits.end(), B.digits.begin());
 }
 
 // operator<()
-// Returns true if and only if A is less than B. 
+// Returns true if and only if A is less than B.
 bool operator<( const BigInteger& A, const BigInteger& B ) {
     if (A.compare(B) == -1) {
         return true;
@@ -586,7 +4088,7 @@ bool operator<( const BigInteger& A, const BigInteger& B ) {
 }
 
 // operator<=()
-// Returns true if and only if A is less than or equal to B. 
+// Returns true if and only if A is less than or equal to B.
 bool operator<=( const BigInteger& A, const BigInteger& B ) {
     if (A.compare(B) <= 0) {
         return true;
@@ -595,7 +4097,7 @@ bool operator<=( const BigInteger& A, const BigInteger& B ) {
 }
 
 // operator>()
-// Returns true if and only if A is greater than B. 
+// Returns true if and only if A is greater than B.
 bool operator>( const BigInteger& A, const BigInteger& B ) {
     if (A.compare(B) == 1) {
         return true;
@@ -604,7 +4106,7 @@ bool operator>( const BigInteger& A, const BigInteger& B ) {
 }
 
 // operator>=()
-// Returns true if and only if A is greater than or equal to B. 
+// Returns true if and only if A is greater than or equal to B.
 bool operator>=( const BigInteger& A, const BigInteger& B ) {
     if (A.compare(B) >= 0) {
         return true;
@@ -613,40 +4115,109 @@ bool operator>=( const BigInteger& A, const BigInteger& B ) {
 }
 
 // operator+()
-// Returns the sum A+B. 
+// Returns the sum A+B.
 BigInteger operator+( const BigInteger& A, const BigInteger& B ) {
     return A.BigInteger::add(B);
 }
 
 // operator+=()
-// Overwrites A with the sum A+B. 
-BigInteger operator+=( BigInteger& A, const BigInteger& B ) {
-    A = A.BigInteger::add(B);
+// Overwrites A with the sum A+B in place and returns A.
+BigInteger& operator+=( BigInteger& A, const BigInteger& B ) {
+    A.addInPlace(B, 1);
     return A;
 }
 
 // operator-()
-// Returns the difference A-B. 
+// Returns the difference A-B.
 BigInteger operator-( const BigInteger& A, const BigInteger& B ) {
     return A.BigInteger::sub(B);
 }
 
 // operator-=()
-// Overwrites A with the difference A-B. 
-BigInteger operator-=( BigInteger& A, const BigInteger& B ) {
-    A = A.BigInteger::sub(B);
+// Overwrites A with the difference A-B in place and returns A.
+BigInteger& operator-=( BigInteger& A, const BigInteger& B ) {
+    A.addInPlace(B, -1);
     return A;
 }
 
 // operator*()
-// Returns the product A*B. 
+// Returns the product A*B, taking the squaring path when A and B are the
+// same object.
 BigInteger operator*( const BigInteger& A, const BigInteger& B ) {
+    if( &A==&B ) {
+        return A.square();
+    }
     return A.BigInteger::mult(B);
 }
 
+// operator*()
+// Returns the product A*k.
+BigInteger operator*( const BigInteger& A, long k ) {
+    return A.mult(k);
+}
+
+// operator*()
+// Returns the product k*A.
+BigInteger operator*( long k, const BigInteger& A ) {
+    return A.mult(k);
+}
+
 // operator*=()
-// Overwrites A with the product A*B. 
-BigInteger operator*=( BigInteger& A, const BigInteger& B ) {
-    A = A.BigInteger::mult(B);
+// Overwrites A with the product A*B in place and returns A. The product is
+// formed in a buffer from the ScratchArena that then trades places with A's
+// limbs, and A's old buffer goes back to the arena for the next product.
+BigInteger& operator*=( BigInteger& A, const BigInteger& B ) {
+    if( A.signum==0 || B.signum==0 ) {
+        A.makeZero();
+        return A;
+    }
+
+    int sign = A.signum*B.signum;
+    LimbVector product;
+
+    multLimbs(product, A.digits, B.digits);
+    A.digits.swap(product);
+    A.signum = sign;
+
+    return A;
+}
+
+// operator/()
+// Returns the quotient A/B, truncated toward zero.
+BigInteger operator/( const BigInteger& A, const BigInteger& B ) {
+    return A.BigInteger::div(B);
+}
+
+// operator/()
+// Returns the quotient A/d, truncated toward zero.
+BigInteger operator/( const BigInteger& A, long d ) {
+    return A.BigInteger::div(d);
+}
+
+// operator/=()
+// Overwrites A with the quotient A/B in place and returns A.
+BigInteger& operator/=( BigInteger& A, const BigInteger& B ) {
+    BigInteger R;
+    A.divmod(B, A, R);
+    return A;
+}
+
+// operator%()
+// Returns the remainder A%B, with the sign of A.
+BigInteger operator%( const BigInteger& A, const BigInteger& B ) {
+    return A.BigInteger::mod(B);
+}
+
+// operator%()
+// Returns the remainder A%d, with the sign of A.
+long operator%( const BigInteger& A, long d ) {
+    return A.BigInteger::mod(d);
+}
+
+// operator%=()
+// Overwrites A with the remainder A%B in place and returns A.
+BigInteger& operator%=( BigInteger& A, const BigInteger& B ) {
+    BigInteger Q;
+    A.divmod(B, Q, A);
     return A;
 }
\ No newline at end of file
@@ -4,19 +4,273 @@
 //-----------------------------------------------------------------------------
 #include<iostream>
 #include<string>
-#include"List.h"
+#include<cstdint>
+#include<functional>
 
 #ifndef BIG_INTEGER_H_INCLUDE_
 #define BIG_INTEGER_H_INCLUDE_
 
-// Exported type  -------------------------------------------------------------
+// Exported types -------------------------------------------------------------
+typedef std::uint32_t Limb;    // one base 10^9 digit of a BigInteger
+typedef std::uint64_t DLimb;   // wide enough to hold a Limb*Limb product
+
+class MontgomeryContext;
+class BigIntegerView;
+
+
+// LimbVector -----------------------------------------------------------------
+// Growable array of limbs used for BigInteger magnitudes. Up to INLINE_LIMBS
+// limbs (10^54, enough for any 128-bit value) live inside the object itself
+// and need no heap allocation; longer values spill to a heap buffer that
+// grows geometrically and is drawn from, and handed back to, the calling
+// thread's ScratchArena. The interface mirrors the parts of std::vector the
+// arithmetic routines use.
+class LimbVector{
+
+public:
+
+   static const std::uint32_t INLINE_LIMBS = 6;
+
+   // Longest LimbVector, in limbs: the largest heap buffer size whose
+   // capacity still fits the 32-bit cap field.
+   static const std::uint32_t MAX_LIMBS = 7u << 29;
+
+private:
+
+   // LimbVector Fields
+   Limb* ptr;                       // local or a heap buffer of cap limbs
+   std::uint32_t len;               // number of limbs in use
+   std::uint32_t cap;               // limbs available at ptr
+   Limb local[INLINE_LIMBS];        // inline storage for small values
+
+   // isInline()
+   // Returns true if the limbs are stored inside this object.
+   bool isInline() const { return ptr==local; }
+
+   // allocate()
+   // Returns a heap buffer of at least n limbs from this thread's
+   // ScratchArena, or from the heap if it has none free, and sets cap to
+   // the buffer's size.
+   static Limb* allocate(std::size_t n, std::uint32_t& cap);
+
+   // release()
+   // Hands the heap buffer p of cap limbs back to this thread's
+   // ScratchArena, which frees it if it is full.
+   static void release(Limb* p, std::uint32_t cap);
+
+public:
+
+   // Class Constructors & Destructors ----------------------------------------
+
+   // LimbVector()
+   // Creates an empty LimbVector using inline storage.
+   LimbVector() : ptr(local), len(0), cap(INLINE_LIMBS) {}
+
+   // LimbVector()
+   // Creates a LimbVector of n limbs, each equal to value.
+   LimbVector(std::size_t n, Limb value = 0);
+
+   // LimbVector()
+   // Creates a LimbVector holding a copy of the limbs in [first, last).
+   LimbVector(const Limb* first, const Limb* last);
+
+   // Copy constructor.
+   LimbVector(const LimbVector& L);
+
+   // Move constructor. Steals the heap buffer of L if it has one, otherwise
+   // copies its inline limbs. L is left empty.
+   LimbVector(LimbVector&& L) noexcept;
+
+   // Destructor
+   ~LimbVector() { if( !isInline() ) release(ptr, cap); }
+
+
+   // Access functions --------------------------------------------------------
+
+   std::size_t size() const { return len; }
+   std::size_t capacity() const { return cap; }
+   bool empty() const { return len==0; }
+   Limb* data() { return ptr; }
+   const Limb* data() const { return ptr; }
+   Limb* begin() { return ptr; }
+   const Limb* begin() const { return ptr; }
+   Limb* end() { return ptr + len; }
+   const Limb* end() const { return ptr + len; }
+   Limb& operator[](std::size_t i) { return ptr[i]; }
+   const Limb& operator[](std::size_t i) const { return ptr[i]; }
+   Limb& back() { return ptr[len - 1]; }
+   const Limb& back() const { return ptr[len - 1]; }
+
+
+   // Manipulation procedures -------------------------------------------------
+
+   // reserve()
+   // Makes room for at least n limbs without changing the contents.
+   // Throws std::length_error if n exceeds MAX_LIMBS.
+   void reserve(std::size_t n);
+
+   // resize()
+   // Changes the size to n limbs, filling any new limbs with value.
+   void resize(std::size_t n, Limb value = 0);
+
+   // assign()
+   // Replaces the contents with n copies of value.
+   void assign(std::size_t n, Limb value);
+
+   // assign()
+   // Replaces the contents with a copy of the limbs in [first, last), which
+   // must not lie inside this LimbVector.
+   void assign(const Limb* first, const Limb* last);
+
+   // insert()
+   // Inserts n copies of value before pos.
+   void insert(Limb* pos, std::size_t n, Limb value);
+
+   // insert()
+   // Inserts a copy of the limbs in [first, last), which must not lie inside
+   // this LimbVector, before pos.
+   void insert(Limb* pos, const Limb* first, const Limb* last);
+
+   // erase()
+   // Removes the limbs in [first, last).
+   void erase(Limb* first, Limb* last);
+
+   void push_back(Limb x) { if( len==cap ) reserve(len + 1); ptr[len++] = x; }
+   void pop_back() { len--; }
+   void clear() { len = 0; }
+
+   // swap()
+   // Exchanges the contents of this LimbVector and L.
+   void swap(LimbVector& L) noexcept;
+
+
+   // Overriden Operators -----------------------------------------------------
+
+   // operator=()
+   // Overwrites the contents of this LimbVector with a copy of L's.
+   LimbVector& operator=( const LimbVector& L );
+
+   // operator=()
+   // Overwrites the contents of this LimbVector with L's, stealing L's heap
+   // buffer when it has one. L is left empty.
+   LimbVector& operator=( LimbVector&& L ) noexcept;
+
+};
+
+
+// ScratchArena ---------------------------------------------------------------
+// A cache of free limb buffers that LimbVector draws from and hands back to
+// on one thread. Buffers come in size classes a quarter of an octave apart,
+// so one freed by an operation fits the next request of about the same
+// size: in a loop such as P = A*B every buffer the product needs, the
+// result's included, is recycled from the iteration before and no call to
+// operator new is made once warm. Each thread has a built-in arena, and
+// together these keep up to BigInteger::setScratchLimit() bytes, however
+// many threads there are. An arena of your own, made current with a Scope
+// around a long evaluation, keeps up to its own limit and frees what it
+// holds when destroyed. Buffers are ordinary heap blocks and may outlive
+// the arena they came from.
+class ScratchArena{
+
+public:
+
+   static const int CLASSES = 128;      // size classes up to 2^32 limbs
+
+   // Scope
+   // Makes an arena current on the calling thread from construction to
+   // destruction, then restores the one that was current before. Work the
+   // thread pool runs on other threads uses their own arenas.
+   class Scope{
+   public:
+      explicit Scope(ScratchArena& arena);
+      ~Scope();
+      Scope(const Scope&) = delete;
+      Scope& operator=( const Scope& ) = delete;
+   private:
+      ScratchArena* previous;
+   };
+
+   // ScratchArena()
+   // Creates an empty arena that keeps at most limit bytes of free buffers.
+   explicit ScratchArena(std::size_t limit);
+
+   // Destructor. Frees every buffer the arena holds.
+   ~ScratchArena();
+
+   ScratchArena(const ScratchArena&) = delete;
+   ScratchArena& operator=( const ScratchArena& ) = delete;
+
+   // cachedBytes()
+   // Returns the number of bytes of free buffers the arena holds.
+   std::size_t cachedBytes() const;
+
+   // clear()
+   // Frees every buffer the arena holds.
+   void clear();
+
+private:
+
+   friend class LimbVector;
+
+   // ScratchArena Fields
+   Limb* free_list[CLASSES];            // per class, linked through each buffer's first bytes
+   std::size_t bytes;                   // bytes held in the free lists
+   std::size_t limit;                   // most bytes held at once
+   std::size_t claimed;                 // bytes of the shared budget claimed, if built-in
+   bool builtin;                        // a thread's built-in arena
+
+   // ScratchArena()
+   // Creates a thread's built-in arena, limited by setScratchLimit().
+   ScratchArena();
+
+   // current()
+   // Returns the arena LimbVector uses on this thread, or nullptr once the
+   // thread's built-in arena has been destroyed at thread exit.
+   static ScratchArena* current();
+
+   // take()
+   // Returns a free buffer of class cls, or nullptr if there is none.
+   Limb* take(int cls);
+
+   // keep()
+   // Adds the buffer p of cls's size to the free lists and returns true, or
+   // returns false if that would go over the limit.
+   bool keep(Limb* p, int cls);
+
+   // claim()
+   // Claims at least need more bytes of the budget the built-in arenas
+   // share, returning false if there is not room for them.
+   bool claim(std::size_t need);
+};
+
+
 class BigInteger{
 
 private:
 
    // BigInteger Fields 
-   int signum;    // +1 (positive), -1 (negative), 0 (zero)
-   List digits;   // List of digits in this BigInteger
+   int signum;                // +1 (positive), -1 (negative), 0 (zero)
+   LimbVector digits;         // limbs of this BigInteger, least significant first
+
+   friend class MontgomeryContext;
+   friend class BigIntegerView;
+
+   // addInPlace()
+   // Overwrites this BigInteger with this + sgn*N, reusing its limb storage.
+   void addInPlace(const BigInteger& N, int sgn);
+
+   // gcdInPlace()
+   // Overwrites this with gcd(this, N) and N with 0 by Lehmer's algorithm.
+   // If S is non-null, S[0] and S[1] go through the same steps as this and
+   // N, so S[0] ends as the cofactor of the original this.
+   // Pre: this >= N >= 0
+   void gcdInPlace(BigInteger& N, BigInteger* S);
+
+   // rootMagnitude()
+   // Returns the floor of the k-th root of this by Newton's method, seeded
+   // from the root of the leading limbs.
+   // Pre: this > 0, k >= 2
+   BigInteger rootMagnitude(unsigned long k) const;
 
 public:
 
@@ -35,12 +289,17 @@ public:
    // Constructor that creates a new BigInteger from the string s.
    // Pre: s is a non-empty string consisting of (at least one) base 10 digit
    // {0,1,2,3,4,5,6,7,8,9}, and an optional sign {+,-} prefix.
-   BigInteger(std::string s);
+   BigInteger(const std::string& s);
 
    // BigInteger()
    // Constructor that creates a copy of N.
    BigInteger(const BigInteger& N);
 
+   // BigInteger()
+   // Constructor that takes over the limbs of N without copying them. N is
+   // left in the zero state.
+   BigInteger(BigInteger&& N) noexcept;
+
    // Optional Destuctor
    // ~BigInteger()
    // ~BigInteger();
@@ -58,6 +317,11 @@ public:
    // greater than N or equal to N, respectively.
    int compare(const BigInteger& N) const;
 
+   // hash()
+   // Returns a hash of this BigInteger's value, computed from its limbs in
+   // place. Equal values have equal hashes. Used by std::hash<BigInteger>.
+   std::size_t hash() const;
+
 
    // Manipulation procedures -------------------------------------------------
 
@@ -77,6 +341,10 @@ public:
    // Returns a BigInteger representing the sum of this and N.
    BigInteger add(const BigInteger& N) const;
 
+   // add()
+   // Returns a BigInteger representing the sum of this and k.
+   BigInteger add(long k) const;
+
    // sub()
    // Returns a BigInteger representing the difference of this and N.
    BigInteger sub(const BigInteger& N) const;
@@ -85,6 +353,144 @@ public:
    // Returns a BigInteger representing the product of this and N. 
    BigInteger mult(const BigInteger& N) const;
 
+   // mult()
+   // Returns a BigInteger representing the product of this and k, formed in
+   // a single carry pass.
+   BigInteger mult(long k) const;
+
+   // addmul()
+   // Adds the product A*k to this in place, in a single carry pass.
+   void addmul(const BigInteger& A, long k);
+
+   // assignLinear()
+   // Overwrites this with k[0]*X[0] + ... + k[n-1]*X[n-1], summing the
+   // scaled terms limb by limb in one signed carry pass into this
+   // BigInteger's own storage. Any X[i] may be this. Used by the expression
+   // templates in BigIntegerExpr.h.
+   void assignLinear(const BigInteger* const X[], const long k[], std::size_t n);
+
+   // square()
+   // Returns a BigInteger representing this*this, forming each cross
+   // product only once.
+   BigInteger square() const;
+
+   // div()
+   // Returns the quotient of this divided by N, truncated toward zero.
+   // Pre: N is non-zero.
+   BigInteger div(const BigInteger& N) const;
+
+   // div()
+   // Returns the quotient of this divided by d, truncated toward zero.
+   // Pre: d!=0
+   BigInteger div(long d) const;
+
+   // mod()
+   // Returns the remainder of this divided by N. The remainder is zero or has
+   // the sign of this, so that this == div(N)*N + mod(N).
+   // Pre: N is non-zero.
+   BigInteger mod(const BigInteger& N) const;
+
+   // mod()
+   // Returns the remainder of this divided by d, with the sign of this.
+   // Pre: d!=0
+   long mod(long d) const;
+
+   // divmod()
+   // Overwrites Q and R with div(N) and mod(N), computed together.
+   // Pre: N is non-zero.
+   void divmod(const BigInteger& N, BigInteger& Q, BigInteger& R) const;
+
+
+   // Exponentiation ----------------------------------------------------------
+
+   // pow()
+   // Returns B^e using sliding-window square-and-multiply. pow(B, 0) is 1.
+   friend BigInteger pow( const BigInteger& B, unsigned long e );
+
+   // modpow()
+   // Returns B^E mod M, in the range [0, M). Builds a MontgomeryContext for M
+   // on every call; pass a context instead to amortise that setup.
+   // Pre: E >= 0, M > 0
+   friend BigInteger modpow( const BigInteger& B, const BigInteger& E, const BigInteger& M );
+
+   // modpow()
+   // Returns B^E mod M for the modulus M of ctx, in the range [0, M).
+   // Pre: E >= 0
+   friend BigInteger modpow( const BigInteger& B, const BigInteger& E, const MontgomeryContext& ctx );
+
+
+   // Number theory -----------------------------------------------------------
+
+   // isqrt()
+   // Returns the floor of the square root of this.
+   // Pre: this >= 0
+   BigInteger isqrt() const;
+
+   // iroot()
+   // Returns the k-th root of this, truncated toward zero.
+   // Pre: k >= 1, and k is odd if this < 0
+   BigInteger iroot(unsigned long k) const;
+
+   // isPerfectSquare()
+   // Returns true if and only if this is the square of an integer.
+   bool isPerfectSquare() const;
+
+   // isPerfectPower()
+   // Returns true if and only if this is m^k for some integers m and k >= 2.
+   bool isPerfectPower() const;
+
+   // gcd()
+   // Returns the greatest common divisor of A and B, which is never negative.
+   // gcd(0, 0) is 0.
+   friend BigInteger gcd( const BigInteger& A, const BigInteger& B );
+
+   // xgcd()
+   // Returns g = gcd(A, B) and overwrites S and T with the cofactors
+   // A*S + B*T = g that Euclid's algorithm produces.
+   friend BigInteger xgcd( const BigInteger& A, const BigInteger& B, BigInteger& S, BigInteger& T );
+
+   // modinv()
+   // Returns the inverse of A modulo M, in the range [0, M).
+   // Pre: M > 0, gcd(A, M) = 1
+   friend BigInteger modinv( const BigInteger& A, const BigInteger& M );
+
+
+   // Tuning functions --------------------------------------------------------
+
+   // setMultThresholds()
+   // Sets the operand sizes, in limbs, at which mult() switches from the
+   // schoolbook basecase to Karatsuba and from Karatsuba to Toom-3. The
+   // defaults come from BIGINT_KARATSUBA_THRESHOLD and BIGINT_TOOM3_THRESHOLD.
+   // Pre: 2 <= karatsuba <= toom3
+   static void setMultThresholds(int karatsuba, int toom3);
+
+   // setNTTThreshold()
+   // Sets the operand size, in limbs, at which mult() switches from Toom-3 to
+   // a three-prime number-theoretic transform (default BIGINT_NTT_THRESHOLD).
+   // The transform runs directly on the base 10^9 limbs and is exact.
+   // Pre: ntt >= 2
+   static void setNTTThreshold(int ntt);
+
+   // setMultThreads()
+   // Sets the number of threads mult() may spread one product over; 0 means
+   // one per hardware thread (default BIGINT_MULT_THREADS). Karatsuba and
+   // Toom-3 run their subproducts side by side, the NTT splits its passes,
+   // and unbalanced products split their blocks.
+   // Pre: threads >= 0
+   static void setMultThreads(int threads);
+
+   // setParallelThreshold()
+   // Sets the shorter-operand size, in limbs, below which a product always
+   // runs serially (default BIGINT_PARALLEL_THRESHOLD).
+   // Pre: limbs >= 1
+   static void setParallelThreshold(int limbs);
+
+   // setScratchLimit()
+   // Sets how many bytes of free limb buffers the built-in ScratchArenas of
+   // all threads keep for reuse between them (default BIGINT_SCRATCH_LIMIT).
+   // 0 turns the cache off, so every buffer goes back to the heap.
+   static void setScratchLimit(std::size_t bytes);
+
 
    // Other Functions ---------------------------------------------------------
 
@@ -93,14 +499,62 @@ public:
    // base 10 digits. If this BigInteger is negative, the returned string 
    // will begin with a negative sign '-'. If this BigInteger is zero, the
    // returned string will consist of the character '0' only.
-   std::string to_string();
+   std::string to_string() const;
+
+
+   // Serialization -----------------------------------------------------------
+   // The binary record is a 16-byte header followed by the limbs:
+   //   bytes 0-1   magic "BI"
+   //   byte  2     format version (1)
+   //   byte  3     sign as a signed byte: -1, 0 or 1
+   //   bytes 4-7   limb base, little-endian (1000000000)
+   //   bytes 8-15  limb count n, little-endian
+   //   then n limbs of 4 bytes each, little-endian, least significant first
+   // Every record is a multiple of 4 bytes long, so records laid end to end
+   // from an aligned address keep their limbs aligned.
+
+   // serializedSize()
+   // Returns the number of bytes serialize() writes for this BigInteger.
+   std::size_t serializedSize() const;
+
+   // serialize()
+   // Writes the binary record of this BigInteger to out. Errors are left in
+   // the stream state, as with operator<<.
+   void serialize(std::ostream& out) const;
+
+   // serialize()
+   // Writes the binary record of this BigInteger to the size bytes at
+   // buffer and returns the number of bytes written.
+   // Pre: size >= serializedSize()
+   std::size_t serialize(void* buffer, std::size_t size) const;
+
+   // deserialize()
+   // Overwrites this BigInteger with the binary record read from in. Throws,
+   // leaving this unchanged, if the record is malformed or cut short.
+   void deserialize(std::istream& in);
+
+   // deserialize()
+   // Overwrites this BigInteger with the binary record at the front of the
+   // size bytes at buffer and returns the record's length in bytes. Throws,
+   // leaving this unchanged, if the record is malformed or cut short.
+   std::size_t deserialize(const void* buffer, std::size_t size);
 
 
    // Overriden Operators -----------------------------------------------------
    
+   // operator=()
+   // Overwrites the state of this BigInteger with state of N.
+   BigInteger& operator=( const BigInteger& N );
+
+   // operator=()
+   // Overwrites the state of this BigInteger with state of N, taking over its
+   // limbs without copying them. N is left in the zero state.
+   BigInteger& operator=( BigInteger&& N ) noexcept;
+
    // operator<<()
-   // Inserts string representation of N into stream.
-   friend std::ostream& operator<<( std::ostream& stream, BigInteger N );
+   // Inserts string representation of N into stream, writing the digits
+   // straight to the stream without building the whole string first.
+   friend std::ostream& operator<<( std::ostream& stream, const BigInteger& N );
 
    // operator==()
    // Returns true if and only if A equals B. 
@@ -127,26 +581,162 @@ public:
    friend BigInteger operator+( const BigInteger& A, const BigInteger& B );
 
    // operator+=()
-   // Overwrites A with the sum A+B. 
-   friend BigInteger operator+=( BigInteger& A, const BigInteger& B );
+   // Overwrites A with the sum A+B in place and returns A.
+   friend BigInteger& operator+=( BigInteger& A, const BigInteger& B );
 
    // operator-()
    // Returns the difference A-B. 
    friend BigInteger operator-( const BigInteger& A, const BigInteger& B );
 
    // operator-=()
-   // Overwrites A with the difference A-B. 
-   friend BigInteger operator-=( BigInteger& A, const BigInteger& B );
+   // Overwrites A with the difference A-B in place and returns A.
+   friend BigInteger& operator-=( BigInteger& A, const BigInteger& B );
 
    // operator*()
    // Returns the product A*B. 
    friend BigInteger operator*( const BigInteger& A, const BigInteger& B );
 
+   // operator*()
+   // Returns the product A*k.
+   friend BigInteger operator*( const BigInteger& A, long k );
+
+   // operator*()
+   // Returns the product k*A.
+   friend BigInteger operator*( long k, const BigInteger& A );
+
    // operator*=()
-   // Overwrites A with the product A*B. 
-   friend BigInteger operator*=( BigInteger& A, const BigInteger& B );
+   // Overwrites A with the product A*B in place and returns A.
+   friend BigInteger& operator*=( BigInteger& A, const BigInteger& B );
+
+   // operator/()
+   // Returns the quotient A/B, truncated toward zero.
+   friend BigInteger operator/( const BigInteger& A, const BigInteger& B );
+
+   // operator/()
+   // Returns the quotient A/d, truncated toward zero.
+   friend BigInteger operator/( const BigInteger& A, long d );
+
+   // operator/=()
+   // Overwrites A with the quotient A/B in place and returns A.
+   friend BigInteger& operator/=( BigInteger& A, const BigInteger& B );
+
+   // operator%()
+   // Returns the remainder A%B, with the sign of A.
+   friend BigInteger operator%( const BigInteger& A, const BigInteger& B );
+
+   // operator%()
+   // Returns the remainder A%d, with the sign of A.
+   friend long operator%( const BigInteger& A, long d );
+
+   // operator%=()
+   // Overwrites A with the remainder A%B in place and returns A.
+   friend BigInteger& operator%=( BigInteger& A, const BigInteger& B );
+
+};
+
+
+// MontgomeryContext ----------------------------------------------------------
+// Precomputed state for repeated modpow() calls against one modulus M: the
+// Montgomery constant -M^(-1) mod 10^9 and R^2 mod M (R = 10^(9k) for a
+// k-limb M). Montgomery form needs M coprime to 10; for other moduli the
+// context holds a reciprocal of M for Barrett reduction instead.
+class MontgomeryContext{
+
+private:
+
+   // MontgomeryContext Fields
+   BigInteger modulus;              // M
+   bool montgomery;                 // true if M is coprime to 10
+   Limb minv;                       // -M^(-1) mod BASE
+   LimbVector r2;                   // R^2 mod M
+   LimbVector reciprocal;           // floor(BASE^(2k)/M), for Barrett reduction
+
+   // reduce()
+   // Overwrites T with T*R^(-1) mod M (Montgomery) or T mod M (Barrett).
+   // Pre: T < M^2
+   void reduce(LimbVector& T) const;
+
+public:
+
+   // MontgomeryContext()
+   // Constructor that precomputes everything modpow() needs for modulus M.
+   // Pre: M > 0
+   MontgomeryContext(const BigInteger& M);
+
+   friend BigInteger modpow( const BigInteger& B, const BigInteger& E, const MontgomeryContext& ctx );
+
+};
+
+
+// BigIntegerView -------------------------------------------------------------
+// A read-only view of a BigInteger binary record (see serialize()) in
+// memory the caller owns, such as a memory-mapped file. The limbs are used
+// where they lie and never copied, so the memory must outlive the view and
+// the record must start at a 4-byte aligned address on a little-endian
+// host. Only the header and top limb are validated; toBigInteger() checks
+// every limb.
+class BigIntegerView{
+
+private:
+
+   // BigIntegerView Fields
+   int signum;                // +1 (positive), -1 (negative), 0 (zero)
+   const Limb* limbs;         // the record's limbs, least significant first
+   std::size_t count;         // number of limbs
+
+public:
+
+   // BigIntegerView()
+   // Creates a view of the record at the front of the size bytes at buffer.
+   // Throws if the header is malformed, the record is cut short, or the
+   // limbs cannot be used in place.
+   BigIntegerView(const void* buffer, std::size_t size);
+
+   // sign()
+   // Returns -1, 1 or 0 according to whether the viewed value is negative,
+   // positive or 0.
+   int sign() const;
+
+   // size()
+   // Returns the number of limbs in the viewed value.
+   std::size_t size() const;
+
+   // data()
+   // Returns the viewed limbs, least significant first.
+   const Limb* data() const;
+
+   // recordSize()
+   // Returns the length of the viewed record in bytes, i.e. the offset of
+   // the record that follows it.
+   std::size_t recordSize() const;
+
+   // compare()
+   // Returns -1, 1 or 0 according to whether the viewed value is less than
+   // N, greater than N or equal to N, respectively.
+   int compare(const BigInteger& N) const;
+
+   // hash()
+   // Returns the same hash as N.hash() for a BigInteger N of equal value.
+   std::size_t hash() const;
+
+   // toBigInteger()
+   // Returns a BigInteger holding a copy of the viewed value. Throws if a
+   // limb is out of range.
+   BigInteger toBigInteger() const;
 
 };
 
 
+// std::hash<BigInteger> -------------------------------------------------------
+// Lets BigInteger key std::unordered_map and std::unordered_set.
+namespace std {
+   template<>
+   struct hash<BigInteger> {
+      size_t operator()( const BigInteger& N ) const noexcept {
+         return N.hash();
+      }
+   };
+}
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,392 @@
+//-----------------------------------------------------------------------------
+// BigIntegerExpr.h
+// Opt-in expression templates for the BigInteger ADT. Wrapping an operand in
+// lazy() makes +, -, * and scaling by a long build an expression object
+// instead of a value:
+//
+//    BigInteger D = 9*lazy(A)*lazy(A)*lazy(A)*lazy(A) + 16*lazy(B)*lazy(B)*lazy(B)*lazy(B)*lazy(B);
+//    assign(D, 3*lazy(A) - 2*lazy(B));
+//
+// Nothing is computed until the expression is converted to a BigInteger or
+// passed to assign(). It is then flattened into a sum of scaled terms: each
+// product among them is formed once, with repeated factors raised as
+// powers, and the terms and their scalars are summed in a single carry pass
+// straight into the destination's limbs (BigInteger::assignLinear()), whose
+// storage assign() reuses. The value is exactly what eager evaluation
+// gives. An expression refers to its operands, so they must outlive it:
+// evaluate it in the statement that builds it rather than keeping it.
+//-----------------------------------------------------------------------------
+#include<cstddef>
+#include<limits>
+#include<utility>
+#include"BigInteger.h"
+
+#ifndef BIG_INTEGER_EXPR_H_INCLUDE_
+#define BIG_INTEGER_EXPR_H_INCLUDE_
+
+
+// Flattened forms ------------------------------------------------------------
+
+// scaleOverflows()
+// Sets r to a*b and returns false, or returns true if a*b overflows a long.
+inline bool scaleOverflows(long a, long b, long& r) {
+#if defined(__GNUC__) || defined(__clang__)
+   return __builtin_mul_overflow(a, b, &r);
+#else
+   const long max = std::numeric_limits<long>::max();
+   const long min = std::numeric_limits<long>::min();
+
+   // compare against the bound on the side of zero the product falls
+   if( a!=0 && b!=0 ) {
+      bool over = (a>0) ? (b>0 ? a>max/b : b<min/a)
+                        : (b>0 ? a<min/b : a<max/b);
+      if( over ) {
+         return true;
+      }
+   }
+   r = a*b;
+   return false;
+#endif
+}
+
+// ExprTerms
+// An expression flattened into at most N terms k[i]*X[i]. Each X[i] points
+// at an operand of the expression or at a value formed for it in temp[i].
+template<std::size_t N>
+struct ExprTerms{
+   const BigInteger* X[N];
+   long k[N];
+   BigInteger temp[N];
+   std::size_t count = 0;
+
+   // add()
+   // Appends the term k*x.
+   void add(const BigInteger* x, long c) {
+      X[count] = x;
+      k[count++] = c;
+   }
+
+   // addValue()
+   // Appends the term c*v, keeping v in this term's slot.
+   void addValue(BigInteger&& v, long c) {
+      temp[count] = std::move(v);
+      add(&temp[count], c);
+   }
+};
+
+// ExprFactors
+// The factors of a product, at most N of them, and a scalar collected from
+// scaled factors. Each X[i] points at an operand or at temp[i].
+template<std::size_t N>
+struct ExprFactors{
+   const BigInteger* X[N];
+   BigInteger temp[N];
+   std::size_t count = 0;
+   long scale = 1;
+
+   // add()
+   // Appends the factor x.
+   void add(const BigInteger* x) {
+      X[count++] = x;
+   }
+
+   // addValue()
+   // Appends the factor v, keeping v in this factor's slot.
+   void addValue(BigInteger&& v) {
+      temp[count] = std::move(v);
+      add(&temp[count]);
+   }
+
+   // scaleBy()
+   // Multiplies the collected scalar by s, or appends s as a factor if the
+   // scalar would overflow.
+   void scaleBy(long s) {
+      long product;
+
+      if( scaleOverflows(scale, s, product) ) {
+         addValue(BigInteger(s));
+      }
+      else {
+         scale = product;
+      }
+   }
+
+   // addTo()
+   // Forms the product of the factors, raising repeated ones as powers, and
+   // appends it to out with coefficient c times the collected scalar.
+   template<std::size_t T>
+   void addTo(ExprTerms<T>& out, long c) {
+      BigInteger& P = out.temp[out.count];
+      const BigInteger* product = nullptr;
+
+      for( std::size_t i = 0; i < count; i++ ) {
+         if( X[i]==nullptr ) {
+            continue;
+         }
+
+         unsigned long e = 1;
+         for( std::size_t j = i + 1; j < count; j++ ) {
+            if( X[j]==X[i] ) {
+               X[j] = nullptr;
+               e++;
+            }
+         }
+
+         if( e==1 && product==nullptr ) {
+            product = X[i];
+         }
+         else {
+            BigInteger power = (e==1) ? BigInteger() : (e==2) ? X[i]->square() : pow(*X[i], e);
+            const BigInteger& factor = (e==1) ? *X[i] : power;
+
+            if( product==nullptr ) {
+               P = std::move(power);
+            }
+            else {
+               P = *product * factor;
+            }
+            product = &P;
+         }
+      }
+
+      long k;
+      if( scaleOverflows(c, scale, k) ) {
+         P = product->mult(scale);
+         product = &P;
+         k = c;
+      }
+      out.add(product, k);
+   }
+};
+
+
+// Expressions ----------------------------------------------------------------
+
+// BigIntegerExpr
+// Base of every expression type E, which provides
+//   terms, factors: bounds on the terms and product factors it flattens to
+//   collect(out, k): appends k times its terms to an ExprTerms
+//   collectFactors(out): appends its factors to an ExprFactors
+template<class E>
+struct BigIntegerExpr{
+   const E& self() const { return static_cast<const E&>(*this); }
+
+   // value()
+   // Returns the value of the expression.
+   BigInteger value() const {
+      ExprTerms<E::terms> t;
+      BigInteger R;
+
+      self().collect(t, 1);
+      R.assignLinear(t.X, t.k, t.count);
+
+      return R;
+   }
+
+   // operator BigInteger()
+   // Evaluates the expression.
+   operator BigInteger() const { return value(); }
+};
+
+// LazyRef
+// An operand of an expression.
+class LazyRef : public BigIntegerExpr<LazyRef>{
+public:
+   static const std::size_t terms = 1;
+   static const std::size_t factors = 1;
+
+   explicit LazyRef(const BigInteger& N) : N(N) {}
+
+   template<std::size_t T>
+   void collect(ExprTerms<T>& out, long k) const { out.add(&N, k); }
+
+   template<std::size_t F>
+   void collectFactors(ExprFactors<F>& out) const { out.add(&N); }
+
+private:
+   const BigInteger& N;
+};
+
+// LazyScaled
+// The expression e times the scalar s.
+template<class E>
+class LazyScaled : public BigIntegerExpr<LazyScaled<E>>{
+public:
+   static const std::size_t terms = E::terms;
+   static const std::size_t factors = E::factors + 1;
+
+   LazyScaled(const E& e, long s) : e(e), s(s) {}
+
+   template<std::size_t T>
+   void collect(ExprTerms<T>& out, long k) const {
+      long ks;
+
+      if( scaleOverflows(k, s, ks) ) {
+         out.addValue(e.value().mult(s), k);
+      }
+      else {
+         e.collect(out, ks);
+      }
+   }
+
+   template<std::size_t F>
+   void collectFactors(ExprFactors<F>& out) const {
+      e.collectFactors(out);
+      out.scaleBy(s);
+   }
+
+private:
+   E e;
+   long s;
+};
+
+// LazySum
+// The expression l + sign*r, for sign 1 or -1.
+template<class L, class R>
+class LazySum : public BigIntegerExpr<LazySum<L, R>>{
+public:
+   static const std::size_t terms = L::terms + R::terms;
+   static const std::size_t factors = 1;
+
+   LazySum(const L& l, const R& r, int sign) : l(l), r(r), sign(sign) {}
+
+   template<std::size_t T>
+   void collect(ExprTerms<T>& out, long k) const {
+      l.collect(out, k);
+
+      long ks;
+      if( scaleOverflows(k, sign, ks) ) {
+         out.addValue(r.value().mult(sign), k);
+      }
+      else {
+         r.collect(out, ks);
+      }
+   }
+
+   // a sum inside a product is formed on its own first
+   template<std::size_t F>
+   void collectFactors(ExprFactors<F>& out) const {
+      out.addValue(this->value());
+   }
+
+private:
+   L l;
+   R r;
+   int sign;
+};
+
+// LazyProduct
+// The expression l*r.
+template<class L, class R>
+class LazyProduct : public BigIntegerExpr<LazyProduct<L, R>>{
+public:
+   static const std::size_t terms = 1;
+   static const std::size_t factors = L::factors + R::factors;
+
+   LazyProduct(const L& l, const R& r) : l(l), r(r) {}
+
+   template<std::size_t T>
+   void collect(ExprTerms<T>& out, long k) const {
+      ExprFactors<factors> f;
+
+      collectFactors(f);
+      f.addTo(out, k);
+   }
+
+   template<std::size_t F>
+   void collectFactors(ExprFactors<F>& out) const {
+      l.collectFactors(out);
+      r.collectFactors(out);
+   }
+
+private:
+   L l;
+   R r;
+};
+
+
+// Building expressions -------------------------------------------------------
+
+// lazy()
+// Returns N as an operand of an expression.
+inline LazyRef lazy(const BigInteger& N) {
+   return LazyRef(N);
+}
+
+// assign()
+// Evaluates e into D, reusing D's limb storage, and returns D. D may itself
+// be an operand of e.
+template<class E>
+BigInteger& assign(BigInteger& D, const BigIntegerExpr<E>& e) {
+   ExprTerms<E::terms> t;
+
+   e.self().collect(t, 1);
+   D.assignLinear(t.X, t.k, t.count);
+
+   return D;
+}
+
+// operator+()
+template<class L, class R>
+LazySum<L, R> operator+( const BigIntegerExpr<L>& l, const BigIntegerExpr<R>& r ) {
+   return LazySum<L, R>(l.self(), r.self(), 1);
+}
+
+template<class L>
+LazySum<L, LazyRef> operator+( const BigIntegerExpr<L>& l, const BigInteger& r ) {
+   return LazySum<L, LazyRef>(l.self(), LazyRef(r), 1);
+}
+
+template<class R>
+LazySum<LazyRef, R> operator+( const BigInteger& l, const BigIntegerExpr<R>& r ) {
+   return LazySum<LazyRef, R>(LazyRef(l), r.self(), 1);
+}
+
+// operator-()
+template<class L, class R>
+LazySum<L, R> operator-( const BigIntegerExpr<L>& l, const BigIntegerExpr<R>& r ) {
+   return LazySum<L, R>(l.self(), r.self(), -1);
+}
+
+template<class L>
+LazySum<L, LazyRef> operator-( const BigIntegerExpr<L>& l, const BigInteger& r ) {
+   return LazySum<L, LazyRef>(l.self(), LazyRef(r), -1);
+}
+
+template<class R>
+LazySum<LazyRef, R> operator-( const BigInteger& l, const BigIntegerExpr<R>& r ) {
+   return LazySum<LazyRef, R>(LazyRef(l), r.self(), -1);
+}
+
+template<class E>
+LazyScaled<E> operator-( const BigIntegerExpr<E>& e ) {
+   return LazyScaled<E>(e.self(), -1);
+}
+
+// operator*()
+template<class L, class R>
+LazyProduct<L, R> operator*( const BigIntegerExpr<L>& l, const BigIntegerExpr<R>& r ) {
+   return LazyProduct<L, R>(l.self(), r.self());
+}
+
+template<class L>
+LazyProduct<L, LazyRef> operator*( const BigIntegerExpr<L>& l, const BigInteger& r ) {
+   return LazyProduct<L, LazyRef>(l.self(), LazyRef(r));
+}
+
+template<class R>
+LazyProduct<LazyRef, R> operator*( const BigInteger& l, const BigIntegerExpr<R>& r ) {
+   return LazyProduct<LazyRef, R>(LazyRef(l), r.self());
+}
+
+template<class E>
+LazyScaled<E> operator*( const BigIntegerExpr<E>& e, long s ) {
+   return LazyScaled<E>(e.self(), s);
+}
+
+template<class E>
+LazyScaled<E> operator*( long s, const BigIntegerExpr<E>& e ) {
+   return LazyScaled<E>(e.self(), s);
+}
+
+#endif
\ No newline at end of file